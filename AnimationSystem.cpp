@@ -0,0 +1,84 @@
+#include "AnimationSystem.h"
+#include "Object.h"
+
+#include <math.h>
+#include <thread>
+
+static const float BOB_SPEED = 1.0f / 30.0f;		// degrees of the bobbing sine per ms
+static const float CIRCLE_SPEED = 1.0f / 90.0f;		// degrees on the circle per ms
+static const float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+
+// fewer entities than this are not worth a thread of their own
+static const size_t MIN_ENTITIES_PER_THREAD = 4096;
+
+void AnimationSystem::addBobbing(Object* object, float amplitude)
+{
+	addCircling(object, glm::vec3(0.0f), 0.0f, amplitude);
+	mAngularSpeed.back() = 0.0f;
+}
+
+void AnimationSystem::addCircling(Object* object, const glm::vec3& center, float radius, float amplitude)
+{
+	mObjects.push_back(object);
+	mCenterX.push_back(center.x);
+	mCenterZ.push_back(center.z);
+	mRadius.push_back(radius);
+	mAngularSpeed.push_back(CIRCLE_SPEED);
+	mAmplitude.push_back(amplitude);
+	mOffsetX.push_back(0.0f);
+	mOffsetY.push_back(0.0f);
+	mOffsetZ.push_back(0.0f);
+	mTurn.push_back(0.0f);
+}
+
+void AnimationSystem::clear()
+{
+	mObjects.clear();
+	mCenterX.clear();
+	mCenterZ.clear();
+	mRadius.clear();
+	mAngularSpeed.clear();
+	mAmplitude.clear();
+	mOffsetX.clear();
+	mOffsetY.clear();
+	mOffsetZ.clear();
+	mTurn.clear();
+}
+
+void AnimationSystem::update(float timeInMS, unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	size_t count = mObjects.size();
+	size_t chunkCount = count / MIN_ENTITIES_PER_THREAD;
+	if (chunkCount > threadCount)
+		chunkCount = threadCount;
+	if (chunkCount < 1)
+		chunkCount = 1;
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; i++)
+		workers.push_back(std::thread(&AnimationSystem::updateRange, this, timeInMS, count * i / chunkCount, count * (i + 1) / chunkCount));
+	updateRange(timeInMS, 0, count / chunkCount);
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void AnimationSystem::updateRange(float timeInMS, size_t first, size_t last)
+{
+	// the same bobbing phase for everyone, as the fish swim in a school
+	float bob = sinf(fmodf(timeInMS * BOB_SPEED, 360.0f) * DEGREES_TO_RADIANS);
+
+	// plain loops over the arrays, the compiler vectorizes them apart from the sine and cosine
+	for (size_t i = first; i < last; i++) {
+		float angle = fmodf(timeInMS * mAngularSpeed[i], 360.0f);
+		float radians = angle * DEGREES_TO_RADIANS;
+		mOffsetX[i] = mCenterX[i] + mRadius[i] * sinf(radians);
+		mOffsetZ[i] = mCenterZ[i] - mRadius[i] * cosf(radians);
+		mOffsetY[i] = bob * mAmplitude[i];
+		mTurn[i] = mAngularSpeed[i] > 0.0f ? 90.0f - angle : 0.0f;		// face along the circle
+	}
+
+	for (size_t i = first; i < last; i++)
+		mObjects[i]->setAnimation(glm::vec3(mOffsetX[i], mOffsetY[i], mOffsetZ[i]), mTurn[i]);
+}
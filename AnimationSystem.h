@@ -0,0 +1,45 @@
+#ifndef ANIMATION_SYSTEM_H
+#define ANIMATION_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+
+class Object;
+
+// Swimming motion of the animated objects. The parameters and results are stored as structure of arrays and
+// evaluated once per frame before the render passes, split over threads when there are many entities.
+// The result is handed to each object as an offset and a turn around the y axis, the objects keep their base transform.
+class AnimationSystem {
+public:
+	// up and down in place
+	void addBobbing(Object* object, float amplitude);
+	// up and down while swimming clockwise on a circle around center
+	void addCircling(Object* object, const glm::vec3& center, float radius, float amplitude);
+	void clear();
+
+	// threadCount 0 uses the hardware concurrency
+	void update(float timeInMS, unsigned int threadCount = 0);
+
+	size_t size() const { return mObjects.size(); }
+
+private:
+	void updateRange(float timeInMS, size_t first, size_t last);
+
+	std::vector<Object*> mObjects;
+
+	// animation parameters
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;			// 0 for bobbing in place
+	std::vector<float> mAngularSpeed;	// degrees per ms on the circle
+	std::vector<float> mAmplitude;		// of the bobbing
+
+	// results of the last update
+	std::vector<float> mOffsetX;
+	std::vector<float> mOffsetY;
+	std::vector<float> mOffsetZ;
+	std::vector<float> mTurn;			// degrees around the y axis
+};
+
+#endif
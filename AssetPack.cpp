@@ -0,0 +1,205 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "AssetPack.h"
+#include "MappedFile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const char PACK_MAGIC[4] = { 'A', 'P', 'A', 'K' };
+static const uint32_t PACK_VERSION = 1;
+static const uint64_t PACK_ALIGNMENT = 64;
+
+struct AssetPackHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t reserved;
+};
+
+struct AssetPackEntry {
+	uint64_t hash;
+	uint64_t offset;			// from the start of the pack
+	uint64_t size;
+	uint32_t nameOffset;		// into the name block, which follows the table
+	uint32_t nameLength;
+};
+
+static MappedFile* mountedPack = nullptr;
+static const AssetPackEntry* mountedEntries = nullptr;
+static const char* mountedNames = nullptr;
+static uint32_t mountedEntryCount = 0;
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+}
+
+// 64-bit offsets, fseek takes a long which has 32 bits on Windows
+static bool seekTo(FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+	return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// names are stored with forward slashes, so lookups work with either separator
+static std::string normalizeName(const std::string& name)
+{
+	std::string normalized = name;
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	return normalized;
+}
+
+bool AssetPack::build(const char* packPath, const std::vector<std::string>& files)
+{
+	std::vector<std::string> names;
+	for (const std::string& file : files) {
+		std::string name = normalizeName(file);
+		if (std::find(names.begin(), names.end(), name) == names.end())
+			names.push_back(name);
+	}
+	std::sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) { return hashName(a) < hashName(b); });
+
+	std::vector<AssetPackEntry> entries(names.size());
+	std::string nameBlock;
+	for (size_t i = 0; i < names.size(); i++) {
+		if (i > 0 && hashName(names[i]) == hashName(names[i - 1])) {
+			printf("[AssetPack] Hash collision between %s and %s\n", names[i - 1].c_str(), names[i].c_str());
+			return false;
+		}
+		entries[i].hash = hashName(names[i]);
+		entries[i].nameOffset = static_cast<uint32_t>(nameBlock.size());
+		entries[i].nameLength = static_cast<uint32_t>(names[i].size());
+		nameBlock += names[i];
+	}
+
+	FILE* pack = fopen(packPath, "wb");
+	if (pack == NULL) {
+		printf("[AssetPack] Unable to write %s\n", packPath);
+		return false;
+	}
+
+	// the contents are written first, the table is filled in on the way and written last
+	uint64_t offset = alignOffset(sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry) + nameBlock.size());
+	std::vector<char> content;
+	bool written = seekTo(pack, offset);
+	for (size_t i = 0; i < names.size() && written; i++) {
+		MappedFile file(names[i].c_str());
+		if (!file.isOpen()) {
+			printf("[AssetPack] Unable to read %s\n", names[i].c_str());
+			written = false;
+			break;
+		}
+		entries[i].offset = offset;
+		entries[i].size = file.getSize();
+		written = fwrite(file.getData(), 1, file.getSize(), pack) == file.getSize();
+
+		uint64_t next = alignOffset(offset + file.getSize());
+		content.assign(static_cast<size_t>(next - offset - file.getSize()), 0);
+		written = written && fwrite(content.data(), 1, content.size(), pack) == content.size();
+		offset = next;
+	}
+
+	AssetPackHeader header;
+	memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+	header.version = PACK_VERSION;
+	header.entryCount = static_cast<uint32_t>(entries.size());
+	header.reserved = 0;
+	written = written
+		&& seekTo(pack, 0)
+		&& fwrite(&header, sizeof(header), 1, pack) == 1
+		&& fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), pack) == entries.size()
+		&& fwrite(nameBlock.data(), 1, nameBlock.size(), pack) == nameBlock.size();
+	fclose(pack);
+
+	if (written)
+		printf("[AssetPack] Wrote %u files, %llu bytes to %s\n", header.entryCount, static_cast<unsigned long long>(offset), packPath);
+	else
+		remove(packPath);
+	return written;
+}
+
+bool AssetPack::mount(const char* packPath)
+{
+	unmount();
+
+	MappedFile* pack = new MappedFile(packPath);
+	const char* data = pack->getData();
+	size_t size = pack->getSize();
+	if (!pack->isOpen() || size < sizeof(AssetPackHeader)) {
+		delete pack;
+		return false;
+	}
+
+	const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(data);
+	size_t tableEnd = sizeof(AssetPackHeader) + static_cast<size_t>(header->entryCount) * sizeof(AssetPackEntry);
+	if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header->version != PACK_VERSION || tableEnd > size) {
+		printf("[AssetPack] %s is not a valid asset pack\n", packPath);
+		delete pack;
+		return false;
+	}
+
+	const AssetPackEntry* entries = reinterpret_cast<const AssetPackEntry*>(data + sizeof(AssetPackHeader));
+	for (uint32_t i = 0; i < header->entryCount; i++) {
+		if (entries[i].offset + entries[i].size > size || tableEnd + entries[i].nameOffset + entries[i].nameLength > size) {
+			printf("[AssetPack] %s is truncated\n", packPath);
+			delete pack;
+			return false;
+		}
+	}
+
+	mountedPack = pack;
+	mountedEntries = entries;
+	mountedNames = data + tableEnd;
+	mountedEntryCount = header->entryCount;
+	return true;
+}
+
+void AssetPack::unmount()
+{
+	delete mountedPack;
+	mountedPack = nullptr;
+	mountedEntries = nullptr;
+	mountedNames = nullptr;
+	mountedEntryCount = 0;
+}
+
+bool AssetPack::isMounted()
+{
+	return mountedPack != nullptr;
+}
+
+// binary search over the hashes, the stored name guards against collisions with files that are not in the pack.
+// Only reads the mapping, so it can be called from any thread.
+bool AssetPack::find(const std::string& name, const char*& data, size_t& size)
+{
+	if (mountedPack == nullptr)
+		return false;
+
+	std::string normalized = normalizeName(name);
+	uint64_t hash = hashName(normalized);
+	const AssetPackEntry* end = mountedEntries + mountedEntryCount;
+	const AssetPackEntry* entry = std::lower_bound(mountedEntries, end, hash, [](const AssetPackEntry& e, uint64_t h) { return e.hash < h; });
+	if (entry == end || entry->hash != hash || entry->nameLength != normalized.size()
+		|| memcmp(mountedNames + entry->nameOffset, normalized.data(), normalized.size()) != 0)
+		return false;
+
+	data = mountedPack->getData() + entry->offset;
+	size = static_cast<size_t>(entry->size);
+	return true;
+}
+
+// 64-bit FNV-1a
+uint64_t AssetPack::hashName(const std::string& name)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : name) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,26 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// Single file archive of the processed assets (mesh caches, compressed textures, shader sources).
+// build() writes the pack, mount() maps it into memory and find() hands out spans pointing into the mapping,
+// the loaders fall back to the loose files for everything that is not in the pack.
+// Layout: header, table of contents sorted by name hash, names, then the file contents, each aligned to 64 bytes.
+class AssetPack {
+public:
+	static bool build(const char* packPath, const std::vector<std::string>& files);
+
+	static bool mount(const char* packPath);
+	static void unmount();
+	static bool isMounted();
+
+	static bool find(const std::string& name, const char*& data, size_t& size);
+
+private:
+	static uint64_t hashName(const std::string& name);
+};
+
+#endif
@@ -0,0 +1,135 @@
+// Benchmark of FastObjParser against tinyobjloader over every model in Objects/.
+// Also checks that both parsers produce the same attributes and triangles.
+//
+// Not part of main.vcxproj, build it from the repository root, e.g.
+//   g++ -O2 -std=c++17 -pthread -I. Benchmarks/ObjParserBenchmark.cpp FastObjParser.cpp MappedFile.cpp -o ObjParserBenchmark
+//   cl /O2 /EHsc /std:c++17 /I. Benchmarks\ObjParserBenchmark.cpp FastObjParser.cpp MappedFile.cpp
+// and run it from the repository root. An optional argument sets the number of repetitions.
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "FastObjParser.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "External Libraries/tiny_obj_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+
+using Clock = std::chrono::high_resolution_clock;
+
+static bool loadTinyObj(const char* path, ObjMesh& mesh)
+{
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string err;
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path))
+		return false;
+
+	mesh.vertices = attrib.vertices;
+	mesh.normals = attrib.normals;
+	mesh.texCoords = attrib.texcoords;
+	mesh.indices.clear();
+	for (const tinyobj::shape_t& shape : shapes)
+		for (const tinyobj::index_t& index : shape.mesh.indices)
+			mesh.indices.push_back({ index.vertex_index, index.texcoord_index, index.normal_index });
+	return true;
+}
+
+static bool sameFloats(const std::vector<float>& a, const std::vector<float>& b, const char* name, const char* path)
+{
+	if (a.size() != b.size()) {
+		printf("  %s: %s count differs (%zu vs %zu)\n", path, name, a.size(), b.size());
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (fabsf(a[i] - b[i]) > 1e-6f * std::max(1.0f, fabsf(a[i]))) {
+			printf("  %s: %s[%zu] differs (%.9g vs %.9g)\n", path, name, i, a[i], b[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool sameMesh(const ObjMesh& a, const ObjMesh& b, const char* path)
+{
+	if (!sameFloats(a.vertices, b.vertices, "vertex", path) || !sameFloats(a.normals, b.normals, "normal", path)
+		|| !sameFloats(a.texCoords, b.texCoords, "texcoord", path))
+		return false;
+	if (a.indices.size() != b.indices.size()) {
+		printf("  %s: index count differs (%zu vs %zu)\n", path, a.indices.size(), b.indices.size());
+		return false;
+	}
+	for (size_t i = 0; i < a.indices.size(); i++) {
+		if (a.indices[i].vertex != b.indices[i].vertex || a.indices[i].texCoord != b.indices[i].texCoord
+			|| a.indices[i].normal != b.indices[i].normal) {
+			printf("  %s: index %zu differs\n", path, i);
+			return false;
+		}
+	}
+	return true;
+}
+
+// average time of one load in milliseconds
+template <typename Load>
+static double measure(int repetitions, Load load)
+{
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < repetitions; i++)
+		load();
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char** argv)
+{
+	int repetitions = argc > 1 ? std::max(1, atoi(argv[1])) : 20;
+	unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<std::string> files;
+	for (const auto& entry : std::filesystem::directory_iterator("Objects"))
+		if (entry.path().extension() == ".obj")
+			files.push_back(entry.path().generic_string());
+	std::sort(files.begin(), files.end());
+	if (files.empty()) {
+		printf("No .obj files found, run the benchmark from the repository root\n");
+		return 1;
+	}
+
+	printf("%-28s %10s %10s %12s %12s %8s\n", "file", "size (KB)", "tinyobj", "fast 1 thr", "fast N thr", "speedup");
+	double totalTiny = 0.0, totalSingle = 0.0, totalParallel = 0.0;
+	bool allEqual = true;
+
+	for (const std::string& file : files) {
+		const char* path = file.c_str();
+		ObjMesh reference, fast;
+		if (!loadTinyObj(path, reference) || !FastObjParser::load(path, fast, threads)) {
+			printf("  %s: failed to load\n", path);
+			allEqual = false;
+			continue;
+		}
+		allEqual = sameMesh(reference, fast, path) && allEqual;
+
+		ObjMesh mesh;
+		double tiny = measure(repetitions, [&]() { loadTinyObj(path, mesh); });
+		double single = measure(repetitions, [&]() { FastObjParser::load(path, mesh, 1); });
+		double parallel = measure(repetitions, [&]() { FastObjParser::load(path, mesh, threads); });
+		totalTiny += tiny;
+		totalSingle += single;
+		totalParallel += parallel;
+
+		printf("%-28s %10.1f %8.3fms %10.3fms %10.3fms %7.1fx\n", path, std::filesystem::file_size(file) / 1024.0,
+			tiny, single, parallel, tiny / parallel);
+	}
+
+	printf("%-28s %10s %8.3fms %10.3fms %10.3fms %7.1fx\n", "total", "", totalTiny, totalSingle, totalParallel, totalTiny / totalParallel);
+	printf("%s, %u threads, %d repetitions\n", allEqual ? "Output identical to tinyobj" : "OUTPUT DIFFERS FROM TINYOBJ", threads, repetitions);
+	return allEqual ? 0 : 1;
+}
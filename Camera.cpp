@@ -112,6 +112,12 @@ const glm::mat4& Camera::getProjectionMatrix() const
 	return mProjectionMatrix;
 }
 
+// frustum of the current view, the reflected one while the reflection texture is rendered
+Frustum Camera::getFrustum() const
+{
+	return Frustum(mProjectionMatrix * getViewMatrix());
+}
+
 void Camera::updateProjection(float ratio)
 {
 	mRatio = ratio;
@@ -2,6 +2,7 @@
 #define CAMERA_H
 
 #include <glm/glm.hpp>
+#include "Frustum.h"
 
 class Camera
 {
@@ -22,6 +23,7 @@ public:
 	void reflect();
 	const glm::mat4& getViewMatrix() const;
 	const glm::mat4& getProjectionMatrix() const;
+	Frustum getFrustum() const;
 	const glm::vec3& getPosition() const { return mPosition; }
 	const float getFar() const { return mFar; }
 	const float getNear() const { return mNear; }
@@ -0,0 +1,374 @@
+#include "FastObjParser.h"
+#include "MappedFile.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBJ_PARSER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// chunks smaller than this are not worth a thread of their own
+static const size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+static const double POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// result of one chunk, indices referencing earlier chunks are fixed when the chunks are merged
+struct ObjChunk {
+	std::vector<float> vertices;
+	std::vector<float> normals;
+	std::vector<float> texCoords;
+	std::vector<ObjIndex> indices;
+	std::vector<size_t> relativeIndices;	// 3 * index + attribute of negative (relative) indices
+	bool valid = true;
+};
+
+static inline bool isDigit(char c)
+{
+	return static_cast<unsigned int>(c - '0') < 10u;
+}
+
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipSpace(const char* p, const char* end)
+{
+	while (p < end && isSpace(*p))
+		p++;
+	return p;
+}
+
+static inline const char* parseInt(const char* p, const char* end, int& value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+	int result = 0;
+	while (p < end && isDigit(*p)) {
+		result = result * 10 + (*p - '0');
+		p++;
+	}
+	value = negative ? -result : result;
+	return p;
+}
+
+// first '\n' in [begin, end), or end
+const char* FastObjParser::findNewline(const char* p, const char* end)
+{
+#ifdef OBJ_PARSER_SSE2
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (end - p >= 16) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+		if (mask != 0) {
+#ifdef _MSC_VER
+			unsigned long offset;
+			_BitScanForward(&offset, mask);
+			return p + offset;
+#else
+			return p + __builtin_ctz(mask);
+#endif
+		}
+		p += 16;
+	}
+#endif
+	while (p < end && *p != '\n')
+		p++;
+	return p;
+}
+
+// decimal floating point number with optional exponent, returns begin if there is no number
+const char* FastObjParser::parseFloat(const char* begin, const char* end, float& value)
+{
+	const char* p = begin;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	int digits = 0;			// significant digits in the mantissa, 19 always fit into 64 bit
+	bool anyDigit = false;
+
+	while (p < end && isDigit(*p)) {
+		if (digits < 19) {
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			if (mantissa != 0)
+				digits++;
+		}
+		else
+			exponent++;
+		anyDigit = true;
+		p++;
+	}
+	if (p < end && *p == '.') {
+		p++;
+		while (p < end && isDigit(*p)) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				if (mantissa != 0)
+					digits++;
+				exponent--;
+			}
+			anyDigit = true;
+			p++;
+		}
+	}
+	if (!anyDigit) {
+		value = 0.0f;
+		return begin;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+')) {
+			negativeExponent = *e == '-';
+			e++;
+		}
+		if (e < end && isDigit(*e)) {
+			int explicitExponent = 0;
+			while (e < end && isDigit(*e)) {
+				if (explicitExponent < 10000)
+					explicitExponent = explicitExponent * 10 + (*e - '0');
+				e++;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+			p = e;
+		}
+	}
+
+	double result = static_cast<double>(mantissa);
+	if (exponent < 0)
+		result = exponent >= -22 ? result / POWERS_OF_TEN[-exponent] : result * pow(10.0, exponent);
+	else if (exponent > 0)
+		result = exponent <= 22 ? result * POWERS_OF_TEN[exponent] : result * pow(10.0, exponent);
+
+	value = static_cast<float>(negative ? -result : result);
+	return p;
+}
+
+static const char* parseFloats(const char* p, const char* end, std::vector<float>& out, int count)
+{
+	for (int i = 0; i < count; i++) {
+		float value;
+		p = FastObjParser::parseFloat(skipSpace(p, end), end, value);
+		out.push_back(value);
+	}
+	return p;
+}
+
+// one corner of a face: v, v/t, v//n or v/t/n
+static const char* parseCorner(const char* p, const char* end, ObjChunk& chunk, int corner[3], bool relative[3])
+{
+	int counts[3] = {
+		static_cast<int>(chunk.vertices.size() / 3),
+		static_cast<int>(chunk.texCoords.size() / 2),
+		static_cast<int>(chunk.normals.size() / 3)
+	};
+
+	for (int attribute = 0; attribute < 3; attribute++) {
+		corner[attribute] = -1;
+		relative[attribute] = false;
+
+		if (attribute > 0) {
+			if (p >= end || *p != '/')
+				break;
+			p++;
+		}
+		if (p >= end || !(isDigit(*p) || *p == '-' || *p == '+'))
+			continue;		// empty, e.g. the texcoord of v//n
+
+		int value;
+		p = parseInt(p, end, value);
+		if (value > 0)
+			corner[attribute] = value - 1;
+		else if (value < 0) {
+			corner[attribute] = counts[attribute] + value;	// relative to this chunk, fixed in the merge
+			relative[attribute] = true;
+		}
+		else
+			chunk.valid = false;
+	}
+	return p;
+}
+
+static void parseFace(const char* p, const char* end, ObjChunk& chunk)
+{
+	ObjIndex first = { -1, -1, -1 };
+	ObjIndex previous = { -1, -1, -1 };
+	bool firstRelative[3] = { false, false, false };
+	bool previousRelative[3] = { false, false, false };
+	int cornerCount = 0;
+
+	for (p = skipSpace(p, end); p < end; p = skipSpace(p, end)) {
+		int corner[3];
+		bool relative[3];
+		const char* next = parseCorner(p, end, chunk, corner, relative);
+		if (next == p)
+			break;			// garbage at the end of the line
+		p = next;
+
+		ObjIndex index = { corner[0], corner[1], corner[2] };
+		if (cornerCount >= 2) {
+			// fan triangulation: first, previous, current
+			const ObjIndex triangle[3] = { first, previous, index };
+			const bool* triangleRelative[3] = { firstRelative, previousRelative, relative };
+			for (int i = 0; i < 3; i++) {
+				size_t position = chunk.indices.size();
+				chunk.indices.push_back(triangle[i]);
+				for (int attribute = 0; attribute < 3; attribute++)
+					if (triangleRelative[i][attribute])
+						chunk.relativeIndices.push_back(3 * position + attribute);
+			}
+		}
+
+		if (cornerCount == 0) {
+			first = index;
+			for (int i = 0; i < 3; i++)
+				firstRelative[i] = relative[i];
+		}
+		previous = index;
+		for (int i = 0; i < 3; i++)
+			previousRelative[i] = relative[i];
+		cornerCount++;
+	}
+}
+
+static void parseLine(const char* p, const char* end, ObjChunk& chunk)
+{
+	p = skipSpace(p, end);
+	if (end - p < 2)
+		return;
+
+	if (p[0] == 'v') {
+		if (isSpace(p[1]))
+			parseFloats(p + 2, end, chunk.vertices, 3);
+		else if (end - p >= 3 && p[1] == 'n' && isSpace(p[2]))
+			parseFloats(p + 3, end, chunk.normals, 3);
+		else if (end - p >= 3 && p[1] == 't' && isSpace(p[2]))
+			parseFloats(p + 3, end, chunk.texCoords, 2);
+	}
+	else if (p[0] == 'f' && isSpace(p[1]))
+		parseFace(p + 2, end, chunk);
+}
+
+static void parseChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+	for (const char* p = begin; p < end; ) {
+		const char* lineEnd = FastObjParser::findNewline(p, end);
+		parseLine(p, lineEnd, chunk);
+		p = lineEnd + 1;
+	}
+}
+
+bool FastObjParser::load(const char* path, ObjMesh& mesh, unsigned int threadCount)
+{
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		printf("Unable to open obj file %s\n", path);
+		return false;
+	}
+	return parse(file.getData(), file.getSize(), mesh, threadCount);
+}
+
+bool FastObjParser::parse(const char* data, size_t size, ObjMesh& mesh, unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	size_t chunkCount = size / MIN_CHUNK_SIZE;
+	if (chunkCount > threadCount)
+		chunkCount = threadCount;
+	if (chunkCount < 1)
+		chunkCount = 1;
+
+	// split at line ends
+	const char* end = data + size;
+	std::vector<const char*> bounds(chunkCount + 1, end);
+	bounds[0] = data;
+	for (size_t i = 1; i < chunkCount; i++) {
+		const char* split = data + size * i / chunkCount;
+		if (split < bounds[i - 1])
+			split = bounds[i - 1];
+		split = findNewline(split, end);
+		bounds[i] = split < end ? split + 1 : end;
+	}
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; i++)
+		workers.push_back(std::thread(parseChunk, bounds[i], bounds[i + 1], std::ref(chunks[i])));
+	parseChunk(bounds[0], bounds[1], chunks[0]);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// merge, offsetting the relative indices by the attributes of the previous chunks
+	size_t totals[4] = { 0, 0, 0, 0 };
+	for (const ObjChunk& chunk : chunks) {
+		totals[0] += chunk.vertices.size();
+		totals[1] += chunk.texCoords.size();
+		totals[2] += chunk.normals.size();
+		totals[3] += chunk.indices.size();
+	}
+	mesh.vertices.clear();
+	mesh.texCoords.clear();
+	mesh.normals.clear();
+	mesh.indices.clear();
+	mesh.vertices.reserve(totals[0]);
+	mesh.texCoords.reserve(totals[1]);
+	mesh.normals.reserve(totals[2]);
+	mesh.indices.reserve(totals[3]);
+
+	bool valid = true;
+	for (const ObjChunk& chunk : chunks) {
+		int offsets[3] = {
+			static_cast<int>(mesh.vertices.size() / 3),
+			static_cast<int>(mesh.texCoords.size() / 2),
+			static_cast<int>(mesh.normals.size() / 3)
+		};
+		size_t firstIndex = mesh.indices.size();
+
+		mesh.vertices.insert(mesh.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+		mesh.texCoords.insert(mesh.texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+		mesh.normals.insert(mesh.normals.end(), chunk.normals.begin(), chunk.normals.end());
+		mesh.indices.insert(mesh.indices.end(), chunk.indices.begin(), chunk.indices.end());
+
+		for (size_t relative : chunk.relativeIndices) {
+			ObjIndex& index = mesh.indices[firstIndex + relative / 3];
+			int attribute = static_cast<int>(relative % 3);
+			int& value = attribute == 0 ? index.vertex : (attribute == 1 ? index.texCoord : index.normal);
+			value += offsets[attribute];
+		}
+		valid = valid && chunk.valid;
+	}
+
+	// reject indices outside of the attribute arrays instead of reading out of bounds later
+	int counts[3] = {
+		static_cast<int>(mesh.vertices.size() / 3),
+		static_cast<int>(mesh.texCoords.size() / 2),
+		static_cast<int>(mesh.normals.size() / 3)
+	};
+	for (const ObjIndex& index : mesh.indices) {
+		if (index.vertex < 0 || index.vertex >= counts[0] || index.texCoord >= counts[1] || index.normal >= counts[2]
+			|| index.texCoord < -1 || index.normal < -1) {
+			valid = false;
+			break;
+		}
+	}
+	return valid;
+}
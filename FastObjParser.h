@@ -0,0 +1,34 @@
+#ifndef FAST_OBJ_PARSER_H
+#define FAST_OBJ_PARSER_H
+
+#include <vector>
+#include <stddef.h>
+
+// zero based indices of one face corner, -1 if the attribute is missing
+struct ObjIndex {
+	int vertex;
+	int texCoord;
+	int normal;
+};
+
+// raw OBJ data in the layout of tinyobj::attrib_t, faces are triangulated as fans
+struct ObjMesh {
+	std::vector<float> vertices;		// x, y, z
+	std::vector<float> normals;			// x, y, z
+	std::vector<float> texCoords;		// u, v
+	std::vector<ObjIndex> indices;		// three per triangle
+};
+
+// OBJ parser for the model files: the file is memory mapped and split into line aligned chunks which are parsed
+// in parallel. Line ends are searched 16 bytes at a time with SSE2 and numbers are parsed without the C runtime.
+// Only geometry is read (v, vt, vn, f), everything else is skipped.
+class FastObjParser {
+public:
+	static bool load(const char* path, ObjMesh& mesh, unsigned int threadCount = 0);
+	static bool parse(const char* data, size_t size, ObjMesh& mesh, unsigned int threadCount = 0);
+
+	static const char* findNewline(const char* begin, const char* end);
+	static const char* parseFloat(const char* begin, const char* end, float& value);
+};
+
+#endif
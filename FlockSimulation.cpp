@@ -0,0 +1,297 @@
+#include "FlockSimulation.h"
+#include "Terrain.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <thread>
+
+using namespace glm;
+
+// fewer boids than this are not worth a thread of their own
+static const size_t MIN_BOIDS_PER_THREAD = 2048;
+static const float SCALE_VARIATION = 0.2f;		// the fish sizes vary by this fraction around the scale of the school
+static const float TWO_PI = 6.28318531f;
+
+static float horizontalSum(__m128 v)
+{
+	float lanes[4];
+	_mm_storeu_ps(lanes, v);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+FlockSimulation::FlockSimulation(size_t count, const vec3& homeCenter, float homeRadius, float scale, const Settings& settings, unsigned int seed) :
+	mSettings(settings),
+	mCount(count),
+	mHomeCenter(homeCenter),
+	mHomeRadius(homeRadius),
+	mBoundsMin(homeCenter - vec3(homeRadius)),
+	mBoundsMax(homeCenter + vec3(homeRadius))
+{
+	// random positions in the home sphere, swimming in random horizontal directions
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	float speed = 0.5f * (settings.minSpeed + settings.maxSpeed);
+	for (size_t i = 0; i < count; i++) {
+		vec3 offset;
+		do {
+			offset = vec3(unit(random), unit(random), unit(random));
+		} while (dot(offset, offset) > 1.0f);
+		float heading = unit(random) * 0.5f * TWO_PI;
+
+		mX.push_back(homeCenter.x + offset.x * homeRadius);
+		mY.push_back(homeCenter.y + offset.y * homeRadius);
+		mZ.push_back(homeCenter.z + offset.z * homeRadius);
+		mVelocityX.push_back(cosf(heading) * speed);
+		mVelocityY.push_back(0.0f);
+		mVelocityZ.push_back(sinf(heading) * speed);
+		mScale.push_back(scale * (1.0f + SCALE_VARIATION * unit(random)));
+		mPhase.push_back((0.5f * unit(random) + 0.5f) * TWO_PI);
+	}
+
+	for (std::vector<float>* sorted : { &mSortedX, &mSortedY, &mSortedZ, &mSortedVelocityX, &mSortedVelocityY, &mSortedVelocityZ, &mSortedScale, &mSortedPhase })
+		sorted->resize(count + 3, 0.0f);
+
+	// at least two buckets per boid, so that few cells share one
+	uint32_t tableSize = 1;
+	while (tableSize < 2 * count)
+		tableSize <<= 1;
+	mTableMask = tableSize - 1;
+	mCellStart.resize(tableSize + 1);
+	mBoidCell.resize(count);
+	mInstances.resize(count * INSTANCE_FLOATS);
+}
+
+void FlockSimulation::setBoundaries(const Terrain* seafloor, float waterHeight)
+{
+	mSeafloor = seafloor;
+	mWaterHeight = waterHeight;
+
+	vec3 boundsMin, boundsMax;
+	seafloor->getBounds(boundsMin, boundsMax);
+	mTerrainHalfSize = 0.5f * (boundsMax.x - boundsMin.x);
+}
+
+void FlockSimulation::addObstacle(const vec4& sphere)
+{
+	mObstacles.push_back(sphere);
+}
+
+void FlockSimulation::clearObstacles()
+{
+	mObstacles.clear();
+}
+
+int FlockSimulation::cellCoordinate(float value) const
+{
+	return static_cast<int>(floorf(value / mSettings.neighbourRadius));
+}
+
+// spatial hash of Teschner et al., neighbouring cells end up in unrelated buckets
+uint32_t FlockSimulation::cellHash(int x, int y, int z) const
+{
+	return ((static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u)) & mTableMask;
+}
+
+// counting sort of the boids by bucket, the state is copied into the sorted arrays
+void FlockSimulation::buildGrid()
+{
+	std::fill(mCellStart.begin(), mCellStart.end(), 0);
+	for (size_t i = 0; i < mCount; i++) {
+		uint32_t bucket = cellHash(cellCoordinate(mX[i]), cellCoordinate(mY[i]), cellCoordinate(mZ[i]));
+		mBoidCell[i] = bucket;
+		mCellStart[bucket]++;
+	}
+
+	// end of every bucket, filling the buckets from the back leaves the start of every bucket
+	for (size_t b = 1; b < mCellStart.size() - 1; b++)
+		mCellStart[b] += mCellStart[b - 1];
+	mCellStart.back() = static_cast<uint32_t>(mCount);
+
+	for (size_t i = mCount; i-- > 0;) {
+		uint32_t slot = --mCellStart[mBoidCell[i]];
+		mSortedX[slot] = mX[i];
+		mSortedY[slot] = mY[i];
+		mSortedZ[slot] = mZ[i];
+		mSortedVelocityX[slot] = mVelocityX[i];
+		mSortedVelocityY[slot] = mVelocityY[i];
+		mSortedVelocityZ[slot] = mVelocityZ[i];
+		mSortedScale[slot] = mScale[i];
+		mSortedPhase[slot] = mPhase[i];
+	}
+}
+
+void FlockSimulation::update(float deltaTime, unsigned int threadCount)
+{
+	if (mCount == 0)
+		return;
+	buildGrid();
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	size_t chunkCount = mCount / MIN_BOIDS_PER_THREAD;
+	if (chunkCount > threadCount)
+		chunkCount = threadCount;
+	if (chunkCount < 1)
+		chunkCount = 1;
+
+	// the threads only read the sorted arrays and write their own range of the state
+	std::vector<vec3> chunkMin(chunkCount);
+	std::vector<vec3> chunkMax(chunkCount);
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; i++)
+		workers.push_back(std::thread(&FlockSimulation::updateRange, this, deltaTime, mCount * i / chunkCount, mCount * (i + 1) / chunkCount,
+			std::ref(chunkMin[i]), std::ref(chunkMax[i])));
+	updateRange(deltaTime, 0, mCount / chunkCount, chunkMin[0], chunkMax[0]);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	mBoundsMin = chunkMin[0];
+	mBoundsMax = chunkMax[0];
+	for (size_t i = 1; i < chunkCount; i++) {
+		mBoundsMin = min(mBoundsMin, chunkMin[i]);
+		mBoundsMax = max(mBoundsMax, chunkMax[i]);
+	}
+}
+
+void FlockSimulation::updateRange(float deltaTime, size_t first, size_t last, vec3& boundsMin, vec3& boundsMax)
+{
+	const float margin = mSettings.avoidanceMargin;
+	const __m128 radiusSquared = _mm_set1_ps(mSettings.neighbourRadius * mSettings.neighbourRadius);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+
+	boundsMin = vec3(FLT_MAX);
+	boundsMax = vec3(-FLT_MAX);
+
+	for (size_t i = first; i < last; i++) {
+		vec3 position = vec3(mSortedX[i], mSortedY[i], mSortedZ[i]);
+		vec3 velocity = vec3(mSortedVelocityX[i], mSortedVelocityY[i], mSortedVelocityZ[i]);
+		__m128 x = _mm_set1_ps(position.x);
+		__m128 y = _mm_set1_ps(position.y);
+		__m128 z = _mm_set1_ps(position.z);
+		__m128 separationX = zero, separationY = zero, separationZ = zero;
+		__m128 alignmentX = zero, alignmentY = zero, alignmentZ = zero;
+		__m128 cohesionX = zero, cohesionY = zero, cohesionZ = zero;
+		__m128 neighbourCount = zero;
+
+		// the 27 cells around the boid, a bucket shared by several of them is only visited once
+		uint32_t visited[27];
+		int visitedCount = 0;
+		int cellX = cellCoordinate(position.x);
+		int cellY = cellCoordinate(position.y);
+		int cellZ = cellCoordinate(position.z);
+		for (int dz = -1; dz <= 1; dz++) {
+			for (int dy = -1; dy <= 1; dy++) {
+				for (int dx = -1; dx <= 1; dx++) {
+					uint32_t bucket = cellHash(cellX + dx, cellY + dy, cellZ + dz);
+					if (std::find(visited, visited + visitedCount, bucket) != visited + visitedCount)
+						continue;
+					visited[visitedCount++] = bucket;
+
+					// four neighbours at a time, lanes past the bucket end and boids outside the radius are masked.
+					// Boids of other cells in the same bucket are removed by the radius as well.
+					uint32_t end = mCellStart[bucket + 1];
+					__m128i endIndex = _mm_set1_epi32(static_cast<int>(end));
+					for (uint32_t j = mCellStart[bucket]; j < end; j += 4) {
+						__m128 offsetX = _mm_sub_ps(_mm_loadu_ps(&mSortedX[j]), x);
+						__m128 offsetY = _mm_sub_ps(_mm_loadu_ps(&mSortedY[j]), y);
+						__m128 offsetZ = _mm_sub_ps(_mm_loadu_ps(&mSortedZ[j]), z);
+						__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ));
+						__m128i index = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(j)), lanes);
+						__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(distanceSquared, radiusSquared), _mm_cmpgt_ps(distanceSquared, zero)),
+							_mm_castsi128_ps(_mm_cmplt_epi32(index, endIndex)));
+
+						// separation falls off with the distance, the approximate reciprocal is good enough
+						__m128 inverseDistanceSquared = _mm_rcp_ps(distanceSquared);
+						separationX = _mm_add_ps(separationX, _mm_and_ps(inside, _mm_mul_ps(offsetX, inverseDistanceSquared)));
+						separationY = _mm_add_ps(separationY, _mm_and_ps(inside, _mm_mul_ps(offsetY, inverseDistanceSquared)));
+						separationZ = _mm_add_ps(separationZ, _mm_and_ps(inside, _mm_mul_ps(offsetZ, inverseDistanceSquared)));
+						alignmentX = _mm_add_ps(alignmentX, _mm_and_ps(inside, _mm_loadu_ps(&mSortedVelocityX[j])));
+						alignmentY = _mm_add_ps(alignmentY, _mm_and_ps(inside, _mm_loadu_ps(&mSortedVelocityY[j])));
+						alignmentZ = _mm_add_ps(alignmentZ, _mm_and_ps(inside, _mm_loadu_ps(&mSortedVelocityZ[j])));
+						cohesionX = _mm_add_ps(cohesionX, _mm_and_ps(inside, offsetX));
+						cohesionY = _mm_add_ps(cohesionY, _mm_and_ps(inside, offsetY));
+						cohesionZ = _mm_add_ps(cohesionZ, _mm_and_ps(inside, offsetZ));
+						neighbourCount = _mm_add_ps(neighbourCount, _mm_and_ps(inside, one));
+					}
+				}
+			}
+		}
+
+		vec3 acceleration = vec3(0.0f);
+		float neighbours = horizontalSum(neighbourCount);
+		if (neighbours > 0.0f) {
+			// the offsets point from this boid to its neighbours
+			vec3 separation = vec3(horizontalSum(separationX), horizontalSum(separationY), horizontalSum(separationZ));
+			vec3 alignment = vec3(horizontalSum(alignmentX), horizontalSum(alignmentY), horizontalSum(alignmentZ)) / neighbours;
+			vec3 cohesion = vec3(horizontalSum(cohesionX), horizontalSum(cohesionY), horizontalSum(cohesionZ)) / neighbours;
+			acceleration -= mSettings.separationWeight * separation;
+			acceleration += mSettings.alignmentWeight * (alignment - velocity);
+			acceleration += mSettings.cohesionWeight * cohesion;
+		}
+
+		// steer away from everything closer than the margin, harder the closer it gets
+		for (const vec4& obstacle : mObstacles) {
+			vec3 away = position - vec3(obstacle);
+			float distance = length(away);
+			float clearance = distance - obstacle.w;
+			if (clearance < margin && distance > 0.0f)
+				acceleration += away / distance * (mSettings.avoidanceWeight * (1.0f - clearance / margin));
+		}
+		if (mSeafloor != nullptr) {
+			float terrainX = floorf(std::min(std::max(position.x, -mTerrainHalfSize), mTerrainHalfSize));
+			float terrainZ = floorf(std::min(std::max(position.z, -mTerrainHalfSize), mTerrainHalfSize));
+			float clearance = position.y - mSeafloor->getHeightValue(terrainX, terrainZ);
+			if (clearance < margin)
+				acceleration.y += mSettings.avoidanceWeight * (1.0f - clearance / margin);
+		}
+		float surfaceClearance = mWaterHeight - position.y;
+		if (surfaceClearance < margin)
+			acceleration.y -= mSettings.avoidanceWeight * (1.0f - surfaceClearance / margin);
+
+		vec3 toHome = mHomeCenter - position;
+		float homeDistance = length(toHome);
+		if (homeDistance > mHomeRadius)
+			acceleration += toHome / homeDistance * (mSettings.homeWeight * (homeDistance - mHomeRadius));
+
+		float accelerationLength = length(acceleration);
+		if (accelerationLength > mSettings.maxAcceleration)
+			acceleration *= mSettings.maxAcceleration / accelerationLength;
+		velocity += acceleration * deltaTime;
+		float speed = length(velocity);
+		if (speed > mSettings.maxSpeed)
+			velocity *= mSettings.maxSpeed / speed;
+		else if (speed < mSettings.minSpeed && speed > 0.0f)
+			velocity *= mSettings.minSpeed / speed;
+		position += velocity * deltaTime;
+
+		// the new state stays in the sorted order
+		mX[i] = position.x;
+		mY[i] = position.y;
+		mZ[i] = position.z;
+		mVelocityX[i] = velocity.x;
+		mVelocityY[i] = velocity.y;
+		mVelocityZ[i] = velocity.z;
+		mScale[i] = mSortedScale[i];
+		mPhase[i] = fmodf(mSortedPhase[i] + TWO_PI * (mSettings.idleBeatFrequency + mSettings.beatFrequency * length(velocity)) * deltaTime, TWO_PI);
+
+		float* instance = &mInstances[i * INSTANCE_FLOATS];
+		instance[0] = position.x;
+		instance[1] = position.y;
+		instance[2] = position.z;
+		instance[3] = mScale[i];
+		instance[4] = velocity.x;
+		instance[5] = velocity.y;
+		instance[6] = velocity.z;
+		instance[7] = mPhase[i];
+
+		boundsMin = min(boundsMin, position);
+		boundsMax = max(boundsMax, position);
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef FLOCK_SIMULATION_H
+#define FLOCK_SIMULATION_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+class Terrain;
+
+// Boids (Reynolds) for one school of fish: separation, alignment and cohesion with the neighbours, avoidance of
+// obstacle spheres, the seafloor and the water surface and a pull back to the home area of the school.
+// The neighbours are found with a uniform grid hashed into a table that is rebuilt by a counting sort every step.
+// The boids are kept in the order of their cells, so the neighbours of a cell are consecutive in memory and are
+// evaluated four at a time with SSE. The boids are split into ranges that are updated on worker threads.
+class FlockSimulation {
+public:
+	// seconds and world units
+	struct Settings {
+		float neighbourRadius = 3.0f;		// also the cell size of the grid
+		float separationWeight = 4.0f;
+		float alignmentWeight = 1.0f;
+		float cohesionWeight = 0.6f;
+		float avoidanceWeight = 20.0f;
+		float avoidanceMargin = 3.0f;		// distance kept to obstacles, seafloor and surface
+		float homeWeight = 0.5f;
+		float minSpeed = 3.0f;
+		float maxSpeed = 8.0f;
+		float maxAcceleration = 20.0f;
+		float beatFrequency = 0.4f;			// tail beats per second and unit of speed
+		float idleBeatFrequency = 0.5f;		// tail beats per second without speed
+	};
+
+	// the home area is a sphere the fish are spawned in and pulled back into when they leave it
+	FlockSimulation(size_t count, const glm::vec3& homeCenter, float homeRadius, float scale, const Settings& settings, unsigned int seed = 1);
+
+	// seafloor heights and the water surface, the terrain has to be centered in (0,0)
+	void setBoundaries(const Terrain* seafloor, float waterHeight);
+	void addObstacle(const glm::vec4& sphere);			// xyz: center, w: radius
+	void clearObstacles();
+
+	// advances by deltaTime seconds, threadCount 0 uses the hardware concurrency
+	void update(float deltaTime, unsigned int threadCount = 0);
+
+	size_t size() const { return mCount; }
+	const glm::vec3& getBoundsMin() const { return mBoundsMin; }
+	const glm::vec3& getBoundsMax() const { return mBoundsMax; }
+	const glm::vec3& getHomeCenter() const { return mHomeCenter; }
+
+	// per fish: position and scale, velocity and tail beat phase, the input of the instanced draw and its swim animation
+	const std::vector<float>& getInstances() const { return mInstances; }
+	static const size_t INSTANCE_FLOATS = 8;
+
+private:
+	void buildGrid();
+	void updateRange(float deltaTime, size_t first, size_t last, glm::vec3& boundsMin, glm::vec3& boundsMax);
+	uint32_t cellHash(int x, int y, int z) const;
+	int cellCoordinate(float value) const;
+
+	Settings mSettings;
+	size_t mCount;
+	glm::vec3 mHomeCenter;
+	float mHomeRadius;
+
+	const Terrain* mSeafloor = nullptr;
+	float mTerrainHalfSize = 0.0f;
+	float mWaterHeight = 1e30f;
+	std::vector<glm::vec4> mObstacles;
+
+	// state in the cell order of the last step
+	std::vector<float> mX, mY, mZ;
+	std::vector<float> mVelocityX, mVelocityY, mVelocityZ;
+	std::vector<float> mScale, mPhase;
+
+	// state sorted by cell, read by all threads during a step. Padded by three boids for the four wide loads.
+	std::vector<float> mSortedX, mSortedY, mSortedZ;
+	std::vector<float> mSortedVelocityX, mSortedVelocityY, mSortedVelocityZ;
+	std::vector<float> mSortedScale, mSortedPhase;
+
+	// hash table of the grid: boids of bucket b are mCellStart[b] to mCellStart[b + 1] in the sorted arrays
+	std::vector<uint32_t> mCellStart;
+	std::vector<uint32_t> mBoidCell;
+	uint32_t mTableMask = 0;
+
+	std::vector<float> mInstances;
+	glm::vec3 mBoundsMin;
+	glm::vec3 mBoundsMax;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "Frustum.h"
+
+#include <xmmintrin.h>
+
+using namespace glm;
+
+Frustum::Frustum(const mat4& viewProjection)
+{
+	// rows of the matrix, glm stores columns
+	vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	for (int i = 0; i < 3; i++) {
+		mPlanes[2 * i + 0] = rows[3] + rows[i];
+		mPlanes[2 * i + 1] = rows[3] - rows[i];
+	}
+
+	// normalized, so that the plane equation is a signed distance
+	for (vec4& plane : mPlanes)
+		plane = plane / length(vec3(plane));
+}
+
+// written as the negated test of testSpheres, so a NaN center is culled by both
+bool Frustum::isVisible(const vec4& sphere) const
+{
+	for (const vec4& plane : mPlanes)
+		if (!(dot(vec3(plane), vec3(sphere)) + plane.w >= -sphere.w))
+			return false;
+	return true;
+}
+
+bool Frustum::isVisible(const vec3& boundsMin, const vec3& boundsMax) const
+{
+	return intersect(boundsMin, boundsMax) != OUTSIDE;
+}
+
+// the box is outside if its corner furthest along a plane normal is behind that plane,
+// inside if even the nearest corner is in front of every plane
+Frustum::Intersection Frustum::intersect(const vec3& boundsMin, const vec3& boundsMax) const
+{
+	Intersection result = INSIDE;
+	for (const vec4& plane : mPlanes) {
+		vec3 furthest = vec3(plane.x >= 0.0f ? boundsMax.x : boundsMin.x,
+			plane.y >= 0.0f ? boundsMax.y : boundsMin.y,
+			plane.z >= 0.0f ? boundsMax.z : boundsMin.z);
+		vec3 nearest = vec3(plane.x >= 0.0f ? boundsMin.x : boundsMax.x,
+			plane.y >= 0.0f ? boundsMin.y : boundsMax.y,
+			plane.z >= 0.0f ? boundsMin.z : boundsMax.z);
+		if (dot(vec3(plane), furthest) + plane.w < 0.0f)
+			return OUTSIDE;
+		if (dot(vec3(plane), nearest) + plane.w < 0.0f)
+			result = INTERSECTING;
+	}
+	return result;
+}
+
+// four spheres against one plane per step
+unsigned int Frustum::testSpheres(const float* sphereX, const float* sphereY, const float* sphereZ, const float* sphereRadius) const
+{
+	__m128 x = _mm_loadu_ps(sphereX);
+	__m128 y = _mm_loadu_ps(sphereY);
+	__m128 z = _mm_loadu_ps(sphereZ);
+	__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(sphereRadius));
+
+	__m128 inside = _mm_cmpeq_ps(x, x);		// all bits set, NaN centers end up culled
+	for (const vec4& plane : mPlanes) {
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+	}
+	return static_cast<unsigned int>(_mm_movemask_ps(inside));
+}
+
+size_t Frustum::cullSpheres(const SphereBatch& spheres, unsigned char* visible) const
+{
+	size_t count = spheres.size();
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		unsigned int mask = testSpheres(&spheres.x[i], &spheres.y[i], &spheres.z[i], &spheres.radius[i]);
+		for (int k = 0; k < 4; k++) {
+			visible[i + k] = static_cast<unsigned char>((mask >> k) & 1);
+			visibleCount += visible[i + k];
+		}
+	}
+
+	for (; i < count; i++) {
+		visible[i] = isVisible(vec4(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i])) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
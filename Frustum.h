@@ -0,0 +1,41 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+
+// bounding spheres in structure of arrays layout, so that four of them fit into one SSE register per component
+struct SphereBatch {
+	std::vector<float> x, y, z, radius;
+
+	void clear() { x.clear(); y.clear(); z.clear(); radius.clear(); }
+	void add(const glm::vec4& sphere) { x.push_back(sphere.x); y.push_back(sphere.y); z.push_back(sphere.z); radius.push_back(sphere.w); }
+	size_t size() const { return x.size(); }
+};
+
+// view frustum as six planes pointing inwards, extracted from a view projection matrix (Gribb & Hartmann)
+class Frustum {
+public:
+	enum Intersection { OUTSIDE, INTERSECTING, INSIDE };
+
+	Frustum() = default;
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	bool isVisible(const glm::vec4& sphere) const;					// xyz: center, w: radius
+	bool isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+	Intersection intersect(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+	// tests the four spheres starting at the pointers, bit i of the result is set if sphere i is visible
+	unsigned int testSpheres(const float* x, const float* y, const float* z, const float* radius) const;
+
+	// writes 1 for every sphere that intersects the frustum and 0 for the others, returns the number of visible spheres
+	size_t cullSpheres(const SphereBatch& spheres, unsigned char* visible) const;
+
+	const glm::vec4& getPlane(int plane) const { return mPlanes[plane]; }
+
+private:
+	glm::vec4 mPlanes[6];		// left, right, bottom, top, near, far
+};
+
+#endif
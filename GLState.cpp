@@ -0,0 +1,165 @@
+#include "GLState.h"
+
+#include <stdio.h>
+
+static const GLuint UNKNOWN = 0xffffffff;		// never a valid name or enum, forces the next call through
+
+GLuint GLState::sProgram = UNKNOWN;
+GLuint GLState::sActiveUnit = UNKNOWN;
+GLuint GLState::sTextures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+GLuint GLState::sVertexArray = UNKNOWN;
+GLuint GLState::sFramebuffer = UNKNOWN;
+GLint GLState::sViewport[4] = { -1, -1, -1, -1 };
+GLenum GLState::sCapabilities[MAX_CAPABILITIES] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_CLIP_DISTANCE0, GL_SCISSOR_TEST, GL_BLEND, 0, 0, 0 };
+GLuint GLState::sCapabilityStates[MAX_CAPABILITIES];
+GLuint GLState::sDepthFunc = UNKNOWN;
+GLuint GLState::sCullFace = UNKNOWN;
+GLuint GLState::sPolygonMode = UNKNOWN;
+GLState::Counters GLState::sCounters = { 0, 0 };
+
+// counts the call and updates the shadow, returns whether it has to be issued
+bool GLState::changed(GLuint& shadow, GLuint value)
+{
+	if (shadow == value) {
+		sCounters.elided++;
+		return false;
+	}
+	shadow = value;
+	sCounters.issued++;
+	return true;
+}
+
+int GLState::targetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D: return TARGET_2D;
+	case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+	case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+	case GL_TEXTURE_BUFFER: return TARGET_BUFFER;
+	default: return -1;
+	}
+}
+
+void GLState::activeTexture(GLuint unit)
+{
+	if (changed(sActiveUnit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (changed(sProgram, program))
+		glUseProgram(program);
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	int index = targetIndex(target);
+	if (unit >= MAX_TEXTURE_UNITS || index < 0) {
+		printf("[GLState] Texture unit %u or target 0x%x not tracked\n", unit, target);
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		sActiveUnit = unit;
+		return;
+	}
+	// the unit only has to be switched when the binding changes
+	if (changed(sTextures[unit][index], texture)) {
+		activeTexture(unit);
+		glBindTexture(target, texture);
+	}
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+	if (sActiveUnit == UNKNOWN)
+		activeTexture(0);
+	bindTexture(sActiveUnit, target, texture);
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+	if (changed(sVertexArray, vao))
+		glBindVertexArray(vao);
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer)
+{
+	if (changed(sFramebuffer, framebuffer))
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (sViewport[0] == x && sViewport[1] == y && sViewport[2] == width && sViewport[3] == height) {
+		sCounters.elided++;
+		return;
+	}
+	sViewport[0] = x;
+	sViewport[1] = y;
+	sViewport[2] = width;
+	sViewport[3] = height;
+	sCounters.issued++;
+	glViewport(x, y, width, height);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+	for (unsigned int i = 0; i < MAX_CAPABILITIES; i++) {
+		if (sCapabilities[i] != capability)
+			continue;
+		if (changed(sCapabilityStates[i], enabled ? GL_TRUE : GL_FALSE)) {
+			if (enabled)
+				glEnable(capability);
+			else
+				glDisable(capability);
+		}
+		return;
+	}
+	printf("[GLState] Capability 0x%x not tracked\n", capability);
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void GLState::depthFunc(GLenum func)
+{
+	if (changed(sDepthFunc, func))
+		glDepthFunc(func);
+}
+
+void GLState::cullFace(GLenum face)
+{
+	if (changed(sCullFace, face))
+		glCullFace(face);
+}
+
+void GLState::polygonMode(GLenum mode)
+{
+	if (changed(sPolygonMode, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::invalidate()
+{
+	sProgram = UNKNOWN;
+	sActiveUnit = UNKNOWN;
+	for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+		for (unsigned int target = 0; target < TARGET_COUNT; target++)
+			sTextures[unit][target] = UNKNOWN;
+	sVertexArray = UNKNOWN;
+	sFramebuffer = UNKNOWN;
+	for (int i = 0; i < 4; i++)
+		sViewport[i] = -1;
+	for (unsigned int i = 0; i < MAX_CAPABILITIES; i++)
+		sCapabilityStates[i] = UNKNOWN;
+	sDepthFunc = UNKNOWN;
+	sCullFace = UNKNOWN;
+	sPolygonMode = UNKNOWN;
+}
+
+void GLState::resetCounters()
+{
+	sCounters.issued = 0;
+	sCounters.elided = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL state the renderer changes per draw. Every call compares against the last value that was set
+// and only reaches the driver when it differs, e.g. the texture units of a shader that is activated again.
+// All binds of the tracked state have to go through this class, invalidate() forgets the shadow after foreign calls.
+class GLState {
+public:
+	static const unsigned int MAX_TEXTURE_UNITS = 16;
+
+	// GL calls that were issued and skipped since the last resetCounters()
+	struct Counters {
+		unsigned int issued;
+		unsigned int elided;
+	};
+
+	static void useProgram(GLuint program);
+	static void bindTexture(GLuint unit, GLenum target, GLuint texture);	// unit is 0 based, not GL_TEXTURE0
+	static void bindTexture(GLenum target, GLuint texture);					// on the active unit, for texture uploads
+	static void bindVertexArray(GLuint vao);
+	static void bindFramebuffer(GLuint framebuffer);
+	static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	static void setEnabled(GLenum capability, bool enabled);
+	static void depthFunc(GLenum func);
+	static void cullFace(GLenum face);
+	static void polygonMode(GLenum mode);									// front and back
+
+	static const GLint* getViewport() { return sViewport; }
+
+	static void invalidate();												// also needed once after the context is created
+	static void resetCounters();
+	static const Counters& getCounters() { return sCounters; }
+
+private:
+	enum TextureTarget { TARGET_2D, TARGET_2D_ARRAY, TARGET_CUBE_MAP, TARGET_BUFFER, TARGET_COUNT };
+	static const unsigned int MAX_CAPABILITIES = 8;
+
+	static bool changed(GLuint& shadow, GLuint value);
+	static int targetIndex(GLenum target);
+	static void activeTexture(GLuint unit);
+
+	static GLuint sProgram;
+	static GLuint sActiveUnit;
+	static GLuint sTextures[MAX_TEXTURE_UNITS][TARGET_COUNT];
+	static GLuint sVertexArray;
+	static GLuint sFramebuffer;
+	static GLint sViewport[4];
+	static GLenum sCapabilities[MAX_CAPABILITIES];
+	static GLuint sCapabilityStates[MAX_CAPABILITIES];
+	static GLuint sDepthFunc;
+	static GLuint sCullFace;
+	static GLuint sPolygonMode;
+	static Counters sCounters;
+};
+
+#endif
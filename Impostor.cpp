@@ -0,0 +1,157 @@
+#include "Impostor.h"
+#include "Object.h"
+#include "ImpostorShaders.h"
+#include "GLState.h"
+#include "TransformBatch.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace glm;
+
+static const int MAX_LEVEL = 3;		// coarsest mip level, smaller ones would blend neighbouring frames
+
+static GLuint createAtlasTexture(int size)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	GLState::bindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, MAX_LEVEL + 1, GL_RGBA8, size, size);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, MAX_LEVEL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+Impostor::Impostor()
+{
+	// unit quad in the plane of a frame, scaled by the radius in the shader
+	mQuad.begin(GL_TRIANGLES);
+	mQuad.addVertex2f(-1.0f, -1.0f);
+	mQuad.addVertex2f(1.0f, -1.0f);
+	mQuad.addVertex2f(1.0f, 1.0f);
+	mQuad.addVertex2f(-1.0f, 1.0f);
+	mQuad.addIndex1ui(0);
+	mQuad.addIndex1ui(1);
+	mQuad.addIndex1ui(2);
+	mQuad.addIndex1ui(0);
+	mQuad.addIndex1ui(2);
+	mQuad.addIndex1ui(3);
+	mQuad.end();
+}
+
+Impostor::~Impostor()
+{
+	glDeleteTextures(1, &mColorTexture);
+	glDeleteTextures(1, &mNormalDepthTexture);
+}
+
+// the center of the frame on the octahedron unfolded into the square, y points up
+vec3 Impostor::getFrameDirection(int x, int y)
+{
+	float u = 2.0f * (x + 0.5f) / FRAMES - 1.0f;
+	float v = 2.0f * (y + 0.5f) / FRAMES - 1.0f;
+	vec3 direction = vec3(u, 1.0f - fabsf(u) - fabsf(v), v);
+	if (direction.y < 0.0f) {
+		direction.x = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		direction.z = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+	}
+	return normalize(direction);
+}
+
+bool Impostor::bake(Object* mesh, ImpostorShaders* shaders)
+{
+	mCenter = mesh->getBoundsMin() + 0.5f * mesh->getBoundsExtent();
+	mRadius = 0.5f * length(mesh->getBoundsExtent());
+	int size = FRAMES * FRAME_RESOLUTION;
+	if (mColorTexture == 0) {
+		mColorTexture = createAtlasTexture(size);
+		mNormalDepthTexture = createAtlasTexture(size);
+	}
+
+	GLuint framebuffer, depthBuffer;
+	glGenFramebuffers(1, &framebuffer);
+	GLState::bindFramebuffer(framebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mColorTexture, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, mNormalDepthTexture, 0);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete)
+		printf("[Impostor] Framebuffer for %s is incomplete\n", mesh->getName().c_str());
+	else {
+		GLint viewport[4];
+		const GLint* current = GLState::getViewport();
+		for (int i = 0; i < 4; i++)
+			viewport[i] = current[i];
+
+		GLState::viewport(0, 0, size, size);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		GLState::setEnabled(GL_DEPTH_TEST, true);
+		GLState::setEnabled(GL_CLIP_DISTANCE0, false);
+		GLState::depthFunc(GL_LESS);
+		shaders->activate();
+		shaders->setIndex(mesh->getIndex());
+		shaders->setMeshBounds(mesh->getBoundsMin(), mesh->getBoundsExtent());
+
+		// orthographic views of the bounding sphere, looking at the center from every frame direction
+		for (int y = 0; y < FRAMES; y++)
+			for (int x = 0; x < FRAMES; x++) {
+				vec3 direction = getFrameDirection(x, y);
+				vec3 up = fabsf(direction.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+				mat4 view = lookAt(mCenter + 2.0f * mRadius * direction, mCenter, up);
+				mat4 projection = ortho(-mRadius, mRadius, -mRadius, mRadius, mRadius, 3.0f * mRadius);
+				shaders->setFrame(projection * view, direction, mCenter, mRadius);
+				GLState::viewport(x * FRAME_RESOLUTION, y * FRAME_RESOLUTION, FRAME_RESOLUTION, FRAME_RESOLUTION);
+				mesh->drawLod(0);
+			}
+		GLState::viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+
+	GLState::bindFramebuffer(0);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	for (GLuint texture : { mColorTexture, mNormalDepthTexture }) {
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	return complete;
+}
+
+void Impostor::addInstance(int transform)
+{
+	mInstances.push_back(static_cast<float>(transform));
+	mInstances.push_back(static_cast<float>(transform));
+	mInstances.insert(mInstances.end(), 6, 0.0f);
+}
+
+// uploads the instances of the pass and draws all of them, the shaders are active. The instances were added in the
+// order of their transforms, so the instances in one range of a large TransformBatch follow each other.
+void Impostor::draw(TransformBatch& transforms)
+{
+	size_t count = getInstanceCount();
+	size_t capacity = transforms.getCapacity();
+	for (size_t i = 0; i < count; i++)
+		mInstances[8 * i] = static_cast<float>(static_cast<size_t>(mInstances[8 * i + 1]) % capacity);
+	mQuad.setInstanceData(mInstances.data(), count);
+
+	// one draw per range of the transforms
+	size_t first = 0;
+	while (first < count) {
+		size_t batch = static_cast<size_t>(mInstances[8 * first + 1]) / capacity;
+		size_t last = first + 1;
+		while (last < count && static_cast<size_t>(mInstances[8 * last + 1]) / capacity == batch)
+			last++;
+		transforms.select(static_cast<int>(mInstances[8 * first + 1]));
+		mQuad.drawRangeInstanced(0, 6, static_cast<GLsizei>(last - first), static_cast<GLuint>(first));
+		first = last;
+	}
+}
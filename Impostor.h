@@ -0,0 +1,54 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include "VertexArrayObject.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+
+class Object;
+class ImpostorShaders;
+class TransformBatch;
+
+// Octahedral impostor of a mesh: bake() renders the mesh from FRAMES x FRAMES directions, spread over the sphere
+// by the octahedral mapping, into an atlas of colors and of normals with depth. Far away the objects using it are
+// drawn as one quad each, turned to the baked direction nearest to the camera, all of them in one instanced draw.
+// The depth moves the fragments back onto the baked surface, so the quads intersect the terrain like the mesh.
+class Impostor {
+public:
+	static const int FRAMES = 8;				// directions per side of the atlas
+	static const int FRAME_RESOLUTION = 64;		// texels per side of one direction
+
+	Impostor();
+	~Impostor();
+
+	// has to be called on the GL thread once the textures of the shaders are loaded, uses the full detail mesh
+	bool bake(Object* mesh, ImpostorShaders* shaders);
+
+	// object space direction from the center to the camera of a frame, the same mapping as in the shader
+	static glm::vec3 getFrameDirection(int x, int y);
+
+	// instances of the current pass, added with their entry in the TransformBatch of the pass
+	void clearInstances() { mInstances.clear(); }
+	void addInstance(int transform);
+	size_t getInstanceCount() const { return mInstances.size() / 8; }
+	void draw(TransformBatch& transforms);
+
+	GLuint getColorTexture() const { return mColorTexture; }
+	GLuint getNormalDepthTexture() const { return mNormalDepthTexture; }
+	GLuint getVAO() const { return mQuad.getVAO(); }
+	const glm::vec3& getCenter() const { return mCenter; }
+	float getRadius() const { return mRadius; }
+
+private:
+	GLuint mColorTexture = 0;
+	GLuint mNormalDepthTexture = 0;		// xyz: normal, w: depth along the frame direction
+	glm::vec3 mCenter;					// bounding sphere of the mesh in object space
+	float mRadius = 0.0f;
+	VertexArrayObject mQuad;
+	std::vector<float> mInstances;		// two vec4 per instance, x: transform index within its range, y: in the batch
+};
+
+#endif
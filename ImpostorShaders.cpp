@@ -0,0 +1,93 @@
+#include "ImpostorShaders.h"
+#include "Impostor.h"
+#include "GLState.h"
+
+using namespace glm;
+
+ImpostorShaders::ImpostorShaders(Mode mode, std::vector<std::string> textureFile, TextureManager* textures, int numberOfRows, int tileFactor, int terrainResolution) :
+	mMode(mode),
+	mNumberOfRows(numberOfRows),
+	mTileFactor(tileFactor),
+	mTerrainResolution(terrainResolution)
+{
+	mTextureID1 = textures->load(textureFile[0], TextureManager::RGBA);
+	mTextureID2 = textures->load(textureFile[1], TextureManager::RG);
+	mCausticTexture = textures->loadArray(std::vector<std::string>(textureFile.begin() + 2, textureFile.end()), TextureManager::RGBA);
+	mCausticFrameCount = static_cast<float>(textureFile.size() - 2);
+}
+
+// uniforms set per draw, hashed once at compile time
+static constexpr UniformName INDEX_UNIFORM("index");
+static constexpr UniformName MESH_OFFSET_UNIFORM("meshOffset");
+static constexpr UniformName MESH_SCALE_UNIFORM("meshScale");
+static constexpr UniformName FRAME_VIEW_PROJECTION_UNIFORM("frameViewProjection");
+static constexpr UniformName FRAME_DIRECTION_UNIFORM("frameDirection");
+static constexpr UniformName CENTER_UNIFORM("center");
+static constexpr UniformName RADIUS_UNIFORM("radius");
+
+void ImpostorShaders::initUniforms()
+{
+	if (mMode == BAKE) {
+		setUniform("objectTexture", 0);
+		setUniform("normalTexture", 1);
+		setUniform("numberOfRows", mNumberOfRows);
+		return;
+	}
+	setUniform("causticTextures", 2);
+	setUniform("transforms", 4);
+	setUniform("colorAtlas", 5);
+	setUniform("normalDepthAtlas", 6);
+	setUniform("causticFrameCount", mCausticFrameCount);
+	setUniform("tileFactor", mTileFactor);
+	setUniform("terrainResolution", mTerrainResolution);
+	setUniform("frames", Impostor::FRAMES);
+}
+
+void ImpostorShaders::activate()
+{
+	GLState::polygonMode(GL_FILL);
+	if (mMode == BAKE) {
+		GLState::bindTexture(0, GL_TEXTURE_2D, mTextureID1);
+		GLState::bindTexture(1, GL_TEXTURE_2D, mTextureID2);
+	}
+	else {
+		GLState::bindTexture(2, GL_TEXTURE_2D_ARRAY, mCausticTexture);
+		GLState::bindTexture(4, GL_TEXTURE_BUFFER, mTransformTexture);
+	}
+	SimpleShaders::activate();
+}
+
+void ImpostorShaders::setIndex(int index)
+{
+	setUniform(INDEX_UNIFORM, index);
+}
+
+// AABB of the baked mesh, used to dequantize the 16-bit vertex positions
+void ImpostorShaders::setMeshBounds(const vec3& boundsMin, const vec3& boundsExtent)
+{
+	setUniform(MESH_OFFSET_UNIFORM, boundsMin);
+	setUniform(MESH_SCALE_UNIFORM, boundsExtent);
+}
+
+// camera of one frame of the atlas, the depth is stored along the direction relative to the bounding sphere
+void ImpostorShaders::setFrame(const mat4& viewProjection, const vec3& direction, const vec3& center, float radius)
+{
+	setUniform(FRAME_VIEW_PROJECTION_UNIFORM, viewProjection);
+	setUniform(FRAME_DIRECTION_UNIFORM, direction);
+	setUniform(CENTER_UNIFORM, center);
+	setUniform(RADIUS_UNIFORM, radius);
+}
+
+void ImpostorShaders::setTransforms(GLuint transformTexture)
+{
+	mTransformTexture = transformTexture;
+}
+
+// atlas and bounding sphere of the impostor drawn next
+void ImpostorShaders::setImpostor(const Impostor& impostor)
+{
+	GLState::bindTexture(5, GL_TEXTURE_2D, impostor.getColorTexture());
+	GLState::bindTexture(6, GL_TEXTURE_2D, impostor.getNormalDepthTexture());
+	setUniform(CENTER_UNIFORM, impostor.getCenter());
+	setUniform(RADIUS_UNIFORM, impostor.getRadius());
+}
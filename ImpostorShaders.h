@@ -0,0 +1,49 @@
+#ifndef IMPOSTOR_SHADERS_H
+#define IMPOSTOR_SHADERS_H
+
+#include "SimpleShaders.h"
+#include "TextureManager.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+class Impostor;
+
+// Programs of the octahedral impostors: BAKE renders a mesh into the atlas of an Impostor with the texture atlas
+// of the objects, RENDER draws the instanced quads lit and fogged like the objects shader.
+class ImpostorShaders : public SimpleShaders
+{
+public:
+	enum Mode { BAKE, RENDER };
+
+	// the same textures as the ObjectsShaders, they are only loaded once
+	ImpostorShaders(Mode mode, std::vector<std::string> textureFile, TextureManager* textures, int numberOfRows, int tileFactor, int terrainResolution);
+	virtual ~ImpostorShaders() = default;
+
+	void activate() override;
+	GLuint getMainTexture() const override { return mTextureID1; }
+
+	// BAKE
+	void setIndex(int index);
+	void setMeshBounds(const glm::vec3& boundsMin, const glm::vec3& boundsExtent);
+	void setFrame(const glm::mat4& viewProjection, const glm::vec3& direction, const glm::vec3& center, float radius);
+
+	// RENDER
+	void setTransforms(GLuint transformTexture);	// texture buffer of the TransformBatch
+	void setImpostor(const Impostor& impostor);
+
+protected:
+	void initUniforms() override;
+
+private:
+	Mode mMode;
+	GLuint mTextureID1;
+	GLuint mTextureID2;
+	GLuint mCausticTexture;
+	GLuint mTransformTexture = 0;
+	float mCausticFrameCount;
+	const int mNumberOfRows;
+	const int mTileFactor;
+	const int mTerrainResolution;
+};
+
+#endif
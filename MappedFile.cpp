@@ -0,0 +1,82 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	mFileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+		return;
+	mSize = static_cast<size_t>(size.QuadPart);
+	mOpened = true;
+	if (mSize == 0)
+		return;		// empty files can not be mapped
+
+	mMappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMappingHandle == NULL) {
+		mOpened = false;
+		return;
+	}
+	mData = static_cast<const char*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr)
+		mOpened = false;
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle != nullptr)
+		CloseHandle(mMappingHandle);
+	if (mFileHandle != nullptr)
+		CloseHandle(mFileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const char* path)
+{
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return;
+
+	struct stat info;
+	if (fstat(file, &info) == 0) {
+		mSize = static_cast<size_t>(info.st_size);
+		mOpened = true;
+		if (mSize > 0) {
+			void* data = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED) {
+				madvise(data, mSize, MADV_SEQUENTIAL);
+				mData = static_cast<const char*>(data);
+			}
+			else
+				mOpened = false;
+		}
+	}
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr)
+		munmap(const_cast<char*>(mData), mSize);
+}
+
+#endif
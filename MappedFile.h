@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file, unmapped again in the destructor
+class MappedFile {
+public:
+	explicit MappedFile(const char* path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const { return mOpened; }
+	const char* getData() const { return mData; }
+	size_t getSize() const { return mSize; }
+
+private:
+	const char* mData = nullptr;
+	size_t mSize = 0;
+	bool mOpened = false;
+
+#ifdef _WIN32
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,350 @@
+#include "MeshSimplifier.h"
+
+#include <math.h>
+#include <string.h>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace glm;
+
+static const double BORDER_WEIGHT = 10.0;		// keeps open borders (e.g. grass blades) in place
+static const double ATTRIBUTE_WEIGHT = 0.5;		// cost of normal and texcoord differences, relative to the edge length
+static const float MIN_NORMAL_DOT = 0.2f;		// collapses that turn a triangle further than this are rejected
+
+namespace {
+
+// symmetric 4x4 matrix of the plane equations, only the upper triangle is stored, and the sum of the plane weights
+struct Quadric {
+	double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+	double weight;
+};
+
+void addPlane(Quadric& q, const vec3& n, float d, double weight)
+{
+	double x = n.x, y = n.y, z = n.z, w = d;
+	q.a00 += weight * x * x; q.a01 += weight * x * y; q.a02 += weight * x * z; q.a03 += weight * x * w;
+	q.a11 += weight * y * y; q.a12 += weight * y * z; q.a13 += weight * y * w;
+	q.a22 += weight * z * z; q.a23 += weight * z * w;
+	q.a33 += weight * w * w;
+	q.weight += weight;
+}
+
+void addQuadric(Quadric& q, const Quadric& other)
+{
+	q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02; q.a03 += other.a03;
+	q.a11 += other.a11; q.a12 += other.a12; q.a13 += other.a13;
+	q.a22 += other.a22; q.a23 += other.a23;
+	q.a33 += other.a33;
+	q.weight += other.weight;
+}
+
+// weighted mean of the squared distances of p to the planes of the quadric
+double evaluate(const Quadric& q, const vec3& p)
+{
+	double x = p.x, y = p.y, z = p.z;
+	double error = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x
+		+ q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y
+		+ q.a22 * z * z + 2.0 * q.a23 * z
+		+ q.a33;
+	return error > 0.0 && q.weight > 0.0 ? error / q.weight : 0.0;
+}
+
+// candidate collapse of vertex from onto vertex to, outdated when one of the vertices changed since it was queued
+struct Collapse {
+	double cost;
+	uint32_t from, to;
+	uint32_t fromVersion, toVersion;
+
+	bool operator<(const Collapse& other) const { return cost > other.cost; }	// cheapest first
+};
+
+enum VertexKind : unsigned char {
+	VERTEX_INTERIOR,
+	VERTEX_BORDER,
+	VERTEX_LOCKED		// seams and non-manifold vertices
+};
+
+// vertices that only differ in their normal are simplified as one
+struct WeldKey {
+	uint32_t positionId;
+	vec2 texCoord;
+};
+
+// hash and compare the float bits, so that equal keys always hash equal
+template <typename T>
+struct BitwiseHash {
+	size_t operator()(const T& value) const
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < sizeof(T); i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		return static_cast<size_t>(hash);
+	}
+};
+
+template <typename T>
+struct BitwiseEqual {
+	bool operator()(const T& a, const T& b) const { return memcmp(&a, &b, sizeof(T)) == 0; }
+};
+
+}
+
+float MeshSimplifier::simplify(const std::vector<vec3>& positions, const std::vector<uint32_t>& positionIds, const std::vector<vec3>& normals,
+	const std::vector<vec2>& texCoords, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+	std::vector<uint32_t>& result)
+{
+	size_t vertexCount = positions.size();
+	size_t triangleCount = indices.size() / 3;
+
+	// hard edges and flat shading split vertices by their normal only. Such vertices are welded to the first one,
+	// the others are linked from it and the best fitting normal is picked again for the simplified triangles.
+	std::unordered_map<WeldKey, uint32_t, BitwiseHash<WeldKey>, BitwiseEqual<WeldKey>> weldIds;
+	std::vector<uint32_t> welded(vertexCount);
+	std::vector<uint32_t> nextCopy(vertexCount, ~0u);
+	for (size_t i = 0; i < vertexCount; i++) {
+		WeldKey key = { positionIds[i], texCoords[i] };
+		auto inserted = weldIds.insert(std::make_pair(key, static_cast<uint32_t>(i)));
+		uint32_t first = inserted.first->second;
+		welded[i] = first;
+		if (!inserted.second) {
+			nextCopy[i] = nextCopy[first];
+			nextCopy[first] = static_cast<uint32_t>(i);
+		}
+	}
+
+	// welded vertices with the same position id but different texcoords are on a seam
+	std::vector<uint32_t> positionUses(vertexCount > 0 ? *std::max_element(positionIds.begin(), positionIds.end()) + 1 : 0, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+		if (welded[i] == i)
+			positionUses[positionIds[i]]++;
+
+	std::vector<uint32_t> triangles(triangleCount * 3);
+	for (size_t i = 0; i < triangles.size(); i++)
+		triangles[i] = welded[indices[i]];
+
+	// an edge used by one triangle is on a border, by more than two it is non-manifold
+	std::unordered_map<uint64_t, uint32_t> edgeUses;
+	for (size_t t = 0; t < triangleCount; t++)
+		for (int e = 0; e < 3; e++) {
+			uint64_t a = positionIds[triangles[3 * t + e]];
+			uint64_t b = positionIds[triangles[3 * t + (e + 1) % 3]];
+			edgeUses[a < b ? (a << 32) | b : (b << 32) | a]++;
+		}
+
+	std::vector<VertexKind> kind(vertexCount, VERTEX_INTERIOR);
+	std::vector<Quadric> quadrics(vertexCount);
+	memset(quadrics.data(), 0, quadrics.size() * sizeof(Quadric));
+	std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+	// the quadric only gives a weighted mean, the geometric error needs the original planes merged into every vertex
+	std::vector<vec4> trianglePlanes(triangleCount);
+	std::vector<std::vector<uint32_t>> vertexPlanes(vertexCount);
+
+	// texcoord seams are locked
+	for (size_t i = 0; i < vertexCount; i++)
+		if (positionUses[positionIds[i]] > 1)
+			kind[i] = VERTEX_LOCKED;
+
+	for (size_t t = 0; t < triangleCount; t++) {
+		const uint32_t* tri = &triangles[3 * t];
+		vec3 p0 = positions[tri[0]], p1 = positions[tri[1]], p2 = positions[tri[2]];
+		vec3 n = cross(p1 - p0, p2 - p0);
+		float doubleArea = length(n);
+		for (int c = 0; c < 3; c++)
+			vertexTriangles[tri[c]].push_back(static_cast<uint32_t>(t));
+		if (doubleArea <= 0.0f)
+			continue;
+		n /= doubleArea;
+
+		// area weighted plane of the triangle
+		trianglePlanes[t] = vec4(n, -dot(n, p0));
+		for (int c = 0; c < 3; c++) {
+			addPlane(quadrics[tri[c]], n, -dot(n, p0), 0.5 * doubleArea);
+			vertexPlanes[tri[c]].push_back(static_cast<uint32_t>(t));
+		}
+
+		for (int e = 0; e < 3; e++) {
+			uint32_t a = tri[e], b = tri[(e + 1) % 3];
+			uint64_t pa = positionIds[a], pb = positionIds[b];
+			uint32_t uses = edgeUses[pa < pb ? (pa << 32) | pb : (pb << 32) | pa];
+			if (uses > 2) {
+				kind[a] = VERTEX_LOCKED;
+				kind[b] = VERTEX_LOCKED;
+			}
+			else if (uses == 1) {
+				// plane through the border edge perpendicular to the triangle
+				vec3 edge = positions[b] - positions[a];
+				vec3 borderNormal = cross(edge, n);
+				float borderLength = length(borderNormal);
+				if (borderLength > 0.0f) {
+					borderNormal /= borderLength;
+					double weight = BORDER_WEIGHT * dot(edge, edge);
+					addPlane(quadrics[a], borderNormal, -dot(borderNormal, positions[a]), weight);
+					addPlane(quadrics[b], borderNormal, -dot(borderNormal, positions[a]), weight);
+				}
+				for (uint32_t v : { a, b })
+					if (kind[v] == VERTEX_INTERIOR)
+						kind[v] = VERTEX_BORDER;
+			}
+		}
+	}
+
+	std::vector<bool> triangleAlive(triangleCount, true);
+	std::vector<bool> vertexAlive(vertexCount, true);
+	std::vector<uint32_t> version(vertexCount, 0);
+	size_t aliveTriangles = triangleCount;
+
+	auto cost = [&](uint32_t from, uint32_t to) {
+		Quadric q = quadrics[from];
+		addQuadric(q, quadrics[to]);
+		vec3 edge = positions[to] - positions[from];
+		vec3 dn = normals[to] - normals[from];
+		vec2 dt = texCoords[to] - texCoords[from];
+		double attributeDistance = 0.5 * dot(dn, dn) + dot(dt, dt);
+		return evaluate(q, positions[to]) + ATTRIBUTE_WEIGHT * attributeDistance * dot(edge, edge);
+	};
+
+	// vertices that share a live triangle with v
+	auto neighbours = [&](uint32_t v, std::vector<uint32_t>& out) {
+		out.clear();
+		for (uint32_t t : vertexTriangles[v]) {
+			if (!triangleAlive[t])
+				continue;
+			for (int c = 0; c < 3; c++) {
+				uint32_t w = triangles[3 * t + c];
+				if (w != v && std::find(out.begin(), out.end(), w) == out.end())
+					out.push_back(w);
+			}
+		}
+	};
+	// number of live triangles that contain both vertices
+	auto sharedTriangles = [&](uint32_t a, uint32_t b) {
+		int count = 0;
+		for (uint32_t t : vertexTriangles[a])
+			if (triangleAlive[t] && (triangles[3 * t] == b || triangles[3 * t + 1] == b || triangles[3 * t + 2] == b))
+				count++;
+		return count;
+	};
+
+	std::priority_queue<Collapse> queue;
+	auto push = [&](uint32_t from, uint32_t to) {
+		if (kind[from] == VERTEX_LOCKED)
+			return;
+		Collapse collapse = { cost(from, to), from, to, version[from], version[to] };
+		queue.push(collapse);
+	};
+
+	std::vector<uint32_t> ring, otherRing;
+	for (size_t t = 0; t < triangleCount; t++)
+		for (int e = 0; e < 3; e++) {
+			uint32_t a = triangles[3 * t + e], b = triangles[3 * t + (e + 1) % 3];
+			push(a, b);
+			push(b, a);
+		}
+
+	double maxError = 0.0;
+	while (aliveTriangles * 3 > targetIndexCount && !queue.empty()) {
+		Collapse collapse = queue.top();
+		queue.pop();
+		uint32_t u = collapse.from, v = collapse.to;
+		if (!vertexAlive[u] || !vertexAlive[v] || version[u] != collapse.fromVersion || version[v] != collapse.toVersion)
+			continue;
+
+		// borders only collapse along the border, onto another border vertex
+		int shared = sharedTriangles(u, v);
+		if (shared == 0 || (kind[u] == VERTEX_BORDER && (shared != 1 || kind[v] == VERTEX_INTERIOR)))
+			continue;
+		if (kind[u] == VERTEX_INTERIOR && shared != 2)
+			continue;
+
+		// link condition: the end points may only share the neighbours of their common triangles
+		neighbours(u, ring);
+		neighbours(v, otherRing);
+		int common = 0;
+		for (uint32_t w : ring)
+			if (std::find(otherRing.begin(), otherRing.end(), w) != otherRing.end())
+				common++;
+		if (common != shared)
+			continue;
+
+		// reject collapses that flip or degenerate the remaining triangles around u
+		bool flips = false;
+		for (uint32_t t : vertexTriangles[u]) {
+			const uint32_t* tri = &triangles[3 * t];
+			if (!triangleAlive[t] || tri[0] == v || tri[1] == v || tri[2] == v)
+				continue;
+			vec3 before[3], after[3];
+			for (int c = 0; c < 3; c++) {
+				before[c] = positions[tri[c]];
+				after[c] = tri[c] == u ? positions[v] : positions[tri[c]];
+			}
+			vec3 nBefore = cross(before[1] - before[0], before[2] - before[0]);
+			vec3 nAfter = cross(after[1] - after[0], after[2] - after[0]);
+			float lengths = length(nBefore) * length(nAfter);
+			if (lengths <= 0.0f || dot(nBefore, nAfter) < MIN_NORMAL_DOT * lengths) {
+				flips = true;
+				break;
+			}
+		}
+		if (flips)
+			continue;
+
+		for (uint32_t t : vertexTriangles[u]) {
+			if (!triangleAlive[t])
+				continue;
+			uint32_t* tri = &triangles[3 * t];
+			if (tri[0] == v || tri[1] == v || tri[2] == v) {
+				triangleAlive[t] = false;
+				aliveTriangles--;
+				continue;
+			}
+			for (int c = 0; c < 3; c++)
+				if (tri[c] == u)
+					tri[c] = v;
+			vertexTriangles[v].push_back(t);
+		}
+		vertexTriangles[u].clear();
+		vertexAlive[u] = false;
+		addQuadric(quadrics[v], quadrics[u]);
+		version[v]++;
+
+		// the cost orders the collapses, the error is the largest unweighted distance of v to the planes it replaces
+		std::vector<uint32_t>& planes = vertexPlanes[v];
+		planes.insert(planes.end(), vertexPlanes[u].begin(), vertexPlanes[u].end());
+		std::sort(planes.begin(), planes.end());
+		planes.erase(std::unique(planes.begin(), planes.end()), planes.end());
+		std::vector<uint32_t>().swap(vertexPlanes[u]);
+		for (uint32_t t : planes) {
+			const vec4& plane = trianglePlanes[t];
+			maxError = std::max(maxError, fabs(static_cast<double>(dot(vec3(plane), positions[v]) + plane.w)));
+		}
+
+		// drop the triangles that died and requeue every edge around v, their cost depends on its quadric
+		std::vector<uint32_t>& vTriangles = vertexTriangles[v];
+		vTriangles.erase(std::remove_if(vTriangles.begin(), vTriangles.end(), [&](uint32_t t) { return !triangleAlive[t]; }), vTriangles.end());
+		neighbours(v, ring);
+		for (uint32_t w : ring) {
+			push(v, w);
+			push(w, v);
+		}
+	}
+
+	result.clear();
+	result.reserve(aliveTriangles * 3);
+	for (size_t t = 0; t < triangleCount; t++) {
+		if (!triangleAlive[t])
+			continue;
+		const uint32_t* tri = &triangles[3 * t];
+		vec3 faceNormal = cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+		for (int c = 0; c < 3; c++) {
+			uint32_t best = tri[c];
+			for (uint32_t copy = nextCopy[tri[c]]; copy != ~0u; copy = nextCopy[copy])
+				if (dot(normals[copy], faceNormal) > dot(normals[best], faceNormal))
+					best = copy;
+			result.push_back(best);
+		}
+	}
+
+	return static_cast<float>(maxError);
+}
@@ -0,0 +1,24 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+// Quadric error metric simplification of an indexed triangle mesh (Garland & Heckbert).
+// Edges are collapsed onto one of their end points, so the result references the input vertices and keeps their
+// normals and texcoords. Vertices on texcoord seams are locked, open borders only collapse along the border and
+// the normal and texcoord difference of an edge is added to its cost.
+class MeshSimplifier {
+public:
+	// positionIds connects the vertices of one surface point (the OBJ position index), coincident points of
+	// separate surfaces, e.g. both sides of a grass blade, keep different ids.
+	// Writes at most targetIndexCount indices to result if the mesh allows it and returns the largest distance in
+	// object space of a remaining vertex to the planes of the original triangles collapsed into it.
+	static float simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& positionIds, const std::vector<glm::vec3>& normals,
+		const std::vector<glm::vec2>& texCoords, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+		std::vector<uint32_t>& result);
+};
+
+#endif
@@ -1,7 +1,13 @@
 #include "Object.h"
+#include "FastObjParser.h"
+#include "AssetPack.h"
+#include "MeshSimplifier.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include"External Libraries/tiny_obj_loader.h"
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <algorithm>
 
 using namespace glm;
 
@@ -41,11 +47,64 @@ Object::Object(const char* objectFile, vec3 position, float scaleFactor, int ind
 	translate(mPosition);
 }
 
+// create the object from a mesh that has already been loaded, e.g. on a worker thread
+Object::Object(const char* objectFile, vec3 position, float scaleFactor, int index, const QuantizedMesh& mesh) :
+	mFile(objectFile),
+	mPosition(position),
+	mScale(scaleFactor),
+	mIndex(index)
+{
+	upload(mesh);
+	scale(mScale);
+	translate(mPosition);
+}
+
 const mat4& Object::getModelMatrix() {
-	mModelMatrix = mTranslationMatrix * mScaleMatrix * mRotationMatrix;
+	if (mWorldDirty) {
+		if (mLocalDirty) {
+			mLocalMatrix = mTranslationMatrix * mMovementMatrix * mScaleMatrix * mRotationMatrix * mTurnMatrix;
+			mLocalDirty = false;
+		}
+		mModelMatrix = mParent != nullptr ? mParent->getModelMatrix() * mAttachMatrix * mLocalMatrix : mLocalMatrix;
+		mWorldDirty = false;
+	}
 	return mModelMatrix;
 }
 
+void Object::setParent(Object* parent)
+{
+	if (mParent != nullptr)
+		mParent->mChildren.erase(std::find(mParent->mChildren.begin(), mParent->mChildren.end(), this));
+
+	// the current world matrix becomes the local one relative to the parent
+	mat4 world = getModelMatrix();
+	mParent = parent;
+	mAttachMatrix = mat4(1.0f);
+	if (mParent != nullptr) {
+		mParent->mChildren.push_back(this);
+		mAttachMatrix = inverse(mParent->getModelMatrix()) * world * inverse(mLocalMatrix);
+	}
+	worldChanged();
+}
+
+void Object::localChanged()
+{
+	mLocalDirty = true;
+	worldChanged();
+}
+
+// marks the world matrices of the subtree, the children of an already dirty object are dirty as well.
+// Not thread safe for objects with children, the animation system only moves objects without any.
+void Object::worldChanged()
+{
+	mSphereDirty = true;
+	if (mWorldDirty)
+		return;
+	mWorldDirty = true;
+	for (Object* child : mChildren)
+		child->worldChanged();
+}
+
 int Object::getIndex()
 {
 	return mIndex;
@@ -64,50 +123,236 @@ const glm::vec3& Object::getPostion() const
 void Object::translate(vec3 const& v)
 {
 	mTranslationMatrix = glm::translate(mTranslationMatrix, v);
+	localChanged();
+}
+
+void Object::setAnimation(const vec3& offset, float turnAngle)
+{
+	mMovementMatrix = glm::translate(mat4(1.0f), offset);
+	mTurnMatrix = glm::rotate(mat4(1.0f), turnAngle, vec3(0.0f, 1.0f, 0.0f));
+	localChanged();
 }
 
 void Object::rotate(vec3 const& axis, float angle)
 {
 	mRotationMatrix = glm::rotate(mRotationMatrix, angle, axis);
+	localChanged();
 }
 
 void Object::scale(float scaleFactor)
 {
 	mScaleMatrix = glm::scale(mScaleMatrix,vec3(scaleFactor));
+	localChanged();
+}
+
+static const float LOD_TRIANGLE_RATIOS[] = { 0.5f, 0.25f, 0.125f };	// coarser levels of detail, relative to the full mesh
+static const float LOD_MIN_REDUCTION = 0.8f;		// a level that keeps more triangles of the previous one is not worth it
+static const float LOD_PIXEL_ERROR = 1.0f;			// largest simplification error on screen
+static const uint32_t OCCLUDER_MAX_TRIANGLES = 512;	// budget of the finest level of detail used as occluder
+static const size_t CORNER_KEY_LIMIT = size_t(1) << 21;	// position, normal and texcoord indices are packed into 21 bits each
+
+// size of the source file, used to detect outdated mesh caches
+static uint64_t getFileSize(const char* path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+	return static_cast<uint64_t>(file.tellg());
+}
+
+// an edit that keeps the size of the source file still changes its modification time
+static uint64_t getModificationTime(const char* path)
+{
+	struct stat status;
+	return stat(path, &status) == 0 ? static_cast<uint64_t>(status.st_mtime) : 0;
+}
+
+std::string Object::getCachePath(const char* objectFile)
+{
+	return std::string(objectFile) + ".qmesh";
 }
 
 void Object::loadObject()
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string err;
+	upload(loadMesh(mFile));
+}
+
+// load the quantized mesh from its binary cache, or parse the OBJ file and write the cache.
+// Does not touch OpenGL, so it can run on any thread.
+QuantizedMesh Object::loadMesh(const char* objectFile)
+{
+	std::string cachePath = getCachePath(objectFile);
+	QuantizedMesh mesh;
 
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err,mFile)) {
-		printf("Error while loading obj: \s", mFile);
+	// a pack is built from up to date caches, the OBJ file does not need to exist
+	const char* packed;
+	size_t packedSize;
+	if (AssetPack::find(cachePath, packed, packedSize) && mesh.read(packed, packedSize))
+		return mesh;
+
+	uint64_t sourceSize = getFileSize(objectFile);
+	uint64_t sourceTime = getModificationTime(objectFile);
+	if (!mesh.load(cachePath, sourceSize, sourceTime)) {
+		ObjMesh obj;
+		if (!FastObjParser::load(objectFile, obj)) {
+			printf("Error while loading obj: %s\n", objectFile);
+			return mesh;
+		}
+
+		// face corners with the same position, normal and texcoord become one vertex
+		std::vector<glm::vec3> vertices;
+		std::vector<uint32_t> vertexIds;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
+		std::vector<uint32_t> indices;
+		std::unordered_map<uint64_t, uint32_t> corners;
+		indices.reserve(obj.indices.size());
+		// the normal and texcoord indices are stored one higher, -1 means none
+		bool weldCorners = obj.vertices.size() / 3 < CORNER_KEY_LIMIT && obj.normals.size() / 3 < CORNER_KEY_LIMIT
+			&& obj.texCoords.size() / 2 < CORNER_KEY_LIMIT;
+		if (!weldCorners)
+			printf("[Object] %s has too many vertices to pack the corner keys, every corner becomes a vertex\n", objectFile);
+		for (const ObjIndex& idx : obj.indices) {
+			uint32_t vertex = static_cast<uint32_t>(vertices.size());
+			if (weldCorners) {
+				uint64_t key = (static_cast<uint64_t>(idx.vertex) << 42) | (static_cast<uint64_t>(idx.normal + 1) << 21) | static_cast<uint64_t>(idx.texCoord + 1);
+				auto inserted = corners.insert(std::make_pair(key, vertex));
+				if (!inserted.second) {
+					indices.push_back(inserted.first->second);
+					continue;
+				}
+			}
+			indices.push_back(vertex);
+
+			vertices.push_back(vec3(obj.vertices[3 * idx.vertex + 0], obj.vertices[3 * idx.vertex + 1], obj.vertices[3 * idx.vertex + 2]));
+			vertexIds.push_back(idx.vertex);
+			if (idx.normal >= 0)
+				normals.push_back(vec3(obj.normals[3 * idx.normal + 0], obj.normals[3 * idx.normal + 1], obj.normals[3 * idx.normal + 2]));
+			else
+				normals.push_back(vec3(0.0f, 1.0f, 0.0f));
+			if (idx.texCoord >= 0)
+				uvs.push_back(vec2(obj.texCoords[2 * idx.texCoord], 1.0f - obj.texCoords[2 * idx.texCoord + 1]));
+			else
+				uvs.push_back(vec2(0.0f));
+		}
+
+		// the full mesh followed by simplified levels of detail in the same index buffer
+		std::vector<QuantizedMesh::Lod> lods;
+		std::vector<uint32_t> lodIndices = indices;
+		lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+		std::vector<uint32_t> simplified;
+		for (float ratio : LOD_TRIANGLE_RATIOS) {
+			size_t target = static_cast<size_t>(indices.size() / 3 * ratio) * 3;
+			float error = MeshSimplifier::simplify(vertices, vertexIds, normals, uvs, indices, target, simplified);
+			if (simplified.size() > lods.back().indexCount * LOD_MIN_REDUCTION)
+				break;
+			lods.push_back({ static_cast<uint32_t>(lodIndices.size()), static_cast<uint32_t>(simplified.size()), error });
+			lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+		}
+
+		mesh = QuantizedMesh(vertices, normals, uvs, lodIndices, lods);
+		mesh.save(cachePath, sourceSize, sourceTime);
 	}
-	else
-	{
-		begin(GL_TRIANGLES);
-		for (const auto& shape : shapes) {
-			for (size_t f = 0; f < shape.mesh.indices.size() / 3; f++) {
-				tinyobj::index_t idx0 = shape.mesh.indices[3 * f + 0];
-				tinyobj::index_t idx1 = shape.mesh.indices[3 * f + 1];
-				tinyobj::index_t idx2 = shape.mesh.indices[3 * f + 2];
-				
-				addVertex3f(attrib.vertices[3 * idx0.vertex_index + 0], attrib.vertices[3 * idx0.vertex_index + 1], attrib.vertices[3 * idx0.vertex_index + 2]);
-				addVertex3f(attrib.vertices[3 * idx1.vertex_index + 0], attrib.vertices[3 * idx1.vertex_index + 1], attrib.vertices[3 * idx1.vertex_index + 2]);
-				addVertex3f(attrib.vertices[3 * idx2.vertex_index + 0], attrib.vertices[3 * idx2.vertex_index + 1], attrib.vertices[3 * idx2.vertex_index + 2]);
-				
-				addNormal3f(attrib.normals[3 * idx0.normal_index + 0], attrib.normals[3 * idx0.normal_index + 1], attrib.normals[3 * idx0.normal_index + 2]);
-				addNormal3f(attrib.normals[3 * idx1.normal_index + 0], attrib.normals[3 * idx1.normal_index + 1], attrib.normals[3 * idx1.normal_index + 2]);
-				addNormal3f(attrib.normals[3 * idx2.normal_index + 0], attrib.normals[3 * idx2.normal_index + 1], attrib.normals[3 * idx2.normal_index + 2]);
-				
-				addTexCoord2f(attrib.texcoords[2 * idx0.texcoord_index], 1.0f - attrib.texcoords[2 * idx0.texcoord_index + 1]);
-				addTexCoord2f(attrib.texcoords[2 * idx1.texcoord_index], 1.0f - attrib.texcoords[2 * idx1.texcoord_index + 1]);
-				addTexCoord2f(attrib.texcoords[2 * idx2.texcoord_index], 1.0f - attrib.texcoords[2 * idx2.texcoord_index + 1]);
+	return mesh;
+}
+
+// create the vertex buffers, has to be called on the GL thread
+void Object::upload(const QuantizedMesh& mesh)
+{
+	mBoundsMin = mesh.getBoundsMin();
+	mBoundsExtent = mesh.getBoundsExtent();
+	mLods = mesh.mLods;
+	mSphereDirty = true;
+
+	// the finest level of detail within the triangle budget stays on the CPU in case the object is used as occluder.
+	// A simplified surface bulges out up to its error, so every vertex is moved inwards along its normal by the error
+	// and the occluder stays inside the drawn mesh, like the terrain occluder stays below the surface.
+	mOccluderPositions.clear();
+	mOccluderIndices.clear();
+	if (!mesh.mLods.empty()) {
+		size_t occluderLod = 0;
+		while (occluderLod + 1 < mesh.mLods.size() && mesh.mLods[occluderLod].indexCount > 3 * OCCLUDER_MAX_TRIANGLES)
+			occluderLod++;
+		const QuantizedMesh::Lod& lod = mesh.mLods[occluderLod];
+		std::unordered_map<uint32_t, uint32_t> occluderVertices;
+		for (uint32_t i = lod.indexOffset; i < lod.indexOffset + lod.indexCount; i++) {
+			uint32_t vertex = mesh.mIndices[i];
+			auto inserted = occluderVertices.insert(std::make_pair(vertex, static_cast<uint32_t>(mOccluderPositions.size())));
+			if (inserted.second) {
+				vec3 normal = vec3(0.0f);
+				if (!mesh.mNormals.empty())
+					normal = QuantizedMesh::octDecode(vec2(mesh.mNormals[2 * vertex] / 32767.0f, mesh.mNormals[2 * vertex + 1] / 32767.0f));
+				mOccluderPositions.push_back(mesh.getPosition(vertex) - lod.error * normal);
 			}
+			mOccluderIndices.push_back(inserted.first->second);
 		}
-		end();
 	}
-}
\ No newline at end of file
+
+	begin(GL_TRIANGLES);
+	endQuantized(mesh);
+}
+
+// world space sphere around the object space AABB, xyz: center, w: radius. Cached like the world matrix.
+vec4 Object::getBoundingSphere()
+{
+	if (mSphereDirty) {
+		const mat4& modelMatrix = getModelMatrix();
+		float scale = std::max(length(vec3(modelMatrix[0])), std::max(length(vec3(modelMatrix[1])), length(vec3(modelMatrix[2]))));
+		vec3 center = vec3(modelMatrix * vec4(mBoundsMin + 0.5f * mBoundsExtent, 1.0f));
+		mBoundingSphere = vec4(center, 0.5f * length(mBoundsExtent) * scale);
+		mSphereDirty = false;
+	}
+	return mBoundingSphere;
+}
+
+// pick the coarsest level of detail whose simplification error stays below LOD_PIXEL_ERROR on screen.
+// Uses the height of the current viewport, so the smaller reflection and refraction textures get coarser meshes.
+void Object::selectLod(const mat4& viewMatrix, const mat4& projectionMatrix, float viewportHeight)
+{
+	mLod = 0;
+	if (mLods.size() < 2)
+		return;
+
+	vec4 sphere = getBoundingSphere();
+	float meshRadius = 0.5f * length(mBoundsExtent);
+	float scale = meshRadius > 0.0f ? sphere.w / meshRadius : 1.0f;		// no bounds before the mesh is uploaded
+	float distance = length(vec3(viewMatrix * vec4(vec3(sphere), 1.0f))) - sphere.w;	// nearest point of the sphere
+	mLod = getLodForDistance(distance, scale, projectionMatrix, viewportHeight);
+}
+
+// the same selection for the mesh drawn with the given scale at a distance, e.g. the instances of a fish school
+unsigned int Object::getLodForDistance(float distance, float scale, const mat4& projectionMatrix, float viewportHeight) const
+{
+	unsigned int lod = 0;
+	if (distance <= 0.0f)
+		return lod;
+
+	// size of one object space unit in pixels at that distance
+	float pixelsPerUnit = scale * projectionMatrix[1][1] * 0.5f * viewportHeight / distance;
+	while (lod + 1 < mLods.size() && mLods[lod + 1].error * pixelsPerUnit <= LOD_PIXEL_ERROR)
+		lod++;
+	return lod;
+}
+
+void Object::draw()
+{
+	drawLod(mLod);
+}
+
+void Object::drawLod(unsigned int lod)
+{
+	if (mLods.empty()) {
+		VertexArrayObject::draw();
+		return;
+	}
+	drawRange(mLods[lod].indexOffset, mLods[lod].indexCount);
+}
+
+void Object::drawInstanced(GLsizei instanceCount, unsigned int lod, GLuint baseInstance)
+{
+	if (mLods.empty()) {
+		drawRangeInstanced(0, mIndexCount, instanceCount, baseInstance);
+		return;
+	}
+	drawRangeInstanced(mLods[lod].indexOffset, mLods[lod].indexCount, instanceCount, baseInstance);
+}
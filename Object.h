@@ -2,12 +2,17 @@
 #define OBJECT_H
 
 #include "VertexArrayObject.h"
+#include "QuantizedMesh.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
+#include <string>
 
 using namespace glm;
 
+class VertexAnimation;
+class Impostor;
+
 class Object : public VertexArrayObject {
 public:
 
@@ -15,28 +20,77 @@ public:
 	Object(const char* objectFiles, vec3 position);
 	Object(const char* objectFiles, vec3 position, float scale);
 	Object(const char* objectFiles, vec3 position, float scale, int index);
+	Object(const char* objectFiles, vec3 position, float scale, int index, const QuantizedMesh& mesh);
 	virtual ~Object() = default;
 
+	// world matrix, only recomputed after the object or one of its parents changed
 	const mat4& getModelMatrix();
+	// the object keeps its place and moves with the parent from now on, nullptr detaches it
+	void setParent(Object* parent);
+	Object* getParent() const { return mParent; }
 	void translate(vec3 const& v);
 	void rotate(vec3 const& axis, float angle);
 	void scale(float scale);
+	void setAnimation(const vec3& offset, float turnAngle);		// applied on top of the transform, see AnimationSystem
 	int getIndex();
 	std::string getName();
 	const glm::vec3& getPostion() const;
+	const glm::vec3& getBoundsMin() const { return mBoundsMin; }
+	const glm::vec3& getBoundsExtent() const { return mBoundsExtent; }
+
+	vec4 getBoundingSphere();
+	void selectLod(const mat4& viewMatrix, const mat4& projectionMatrix, float viewportHeight);
+	unsigned int getLod() const { return mLod; }
+	unsigned int getLodForDistance(float distance, float scale, const mat4& projectionMatrix, float viewportHeight) const;
+	void draw() override;
+	void drawLod(unsigned int lod);
+	void drawInstanced(GLsizei instanceCount, unsigned int lod, GLuint baseInstance = 0);	// with the instance data of setInstanceData
+	const std::vector<glm::vec3>& getOccluderPositions() const { return mOccluderPositions; }
+	// baked animation replacing the mesh positions, objects sharing one start at different times of the cycle
+	void setVertexAnimation(const VertexAnimation* animation, float cycleOffset) { mVertexAnimation = animation; mAnimationOffset = cycleOffset; }
+	const VertexAnimation* getVertexAnimation() const { return mVertexAnimation; }
+	float getAnimationOffset() const { return mAnimationOffset; }
+	// quad drawn instead of the mesh far away, shared by the objects with the same mesh
+	void setImpostor(Impostor* impostor) { mImpostor = impostor; }
+	Impostor* getImpostor() const { return mImpostor; }
+	const std::vector<uint32_t>& getOccluderIndices() const { return mOccluderIndices; }
+
+	static QuantizedMesh loadMesh(const char* objectFile);
+	static std::string getCachePath(const char* objectFile);
+
+private:
+	void loadObject();
+	void upload(const QuantizedMesh& mesh);
+	void localChanged();
+	void worldChanged();
 
 	mat4 mTranslationMatrix = mat4{ 1.0f };
 	mat4 mRotationMatrix = mat4{ 1.0f };
 	mat4 mScaleMatrix = mat4{ 1.0f };
-	mat4 mModelMatrix = mat4{ 1.0f };
+	mat4 mMovementMatrix = mat4{ 1.0f };	// animation of the current frame
+	mat4 mTurnMatrix = mat4{ 1.0f };
 
-private:
-	void loadObject();
+	// transform hierarchy, a dirty object always has dirty children
+	Object* mParent = nullptr;
+	std::vector<Object*> mChildren;
+	mat4 mAttachMatrix = mat4{ 1.0f };		// inverse world matrix of the parent when it was attached
+	mat4 mLocalMatrix = mat4{ 1.0f };
+	mat4 mModelMatrix = mat4{ 1.0f };
+	vec4 mBoundingSphere;
+	bool mLocalDirty = true;
+	bool mWorldDirty = true;
+	bool mSphereDirty = true;
 
 	const char* mFile;
-	std::vector<glm::vec3> mVertices;
-	std::vector<glm::vec2> mUVs;
-	std::vector<glm::vec3> mNormals;
+	glm::vec3 mBoundsMin;		// object space AABB, needed to dequantize the vertex positions
+	glm::vec3 mBoundsExtent;
+	std::vector<QuantizedMesh::Lod> mLods;	// index ranges, finest first
+	unsigned int mLod = 0;
+	std::vector<glm::vec3> mOccluderPositions;	// shrunk level of detail in object space, for the occlusion culling
+	std::vector<uint32_t> mOccluderIndices;
+	const VertexAnimation* mVertexAnimation = nullptr;
+	float mAnimationOffset = 0.0f;
+	Impostor* mImpostor = nullptr;
 
 	glm::vec3 mPosition;
 	float mScale;
@@ -0,0 +1,67 @@
+#include "ObjectLoader.h"
+
+ObjectLoader::ObjectLoader(const std::vector<Objects>& objects, unsigned int threadCount) :
+	mObjects(objects),
+	mNextFile(0)
+{
+	for (size_t i = 0; i < mObjects.size(); i++) {
+		size_t file = 0;
+		while (file < mFiles.size() && mFiles[file] != mObjects[i].file)
+			file++;
+		if (file == mFiles.size()) {
+			mFiles.push_back(mObjects[i].file);
+			mFileObjects.push_back(std::vector<size_t>());
+		}
+		mFileObjects[file].push_back(i);
+	}
+
+	if (threadCount == 0)
+		threadCount = 1;
+	if (threadCount > mFiles.size())
+		threadCount = static_cast<unsigned int>(mFiles.size());
+	for (unsigned int i = 0; i < threadCount; i++)
+		mWorkers.push_back(std::thread(&ObjectLoader::work, this));
+}
+
+ObjectLoader::~ObjectLoader()
+{
+	for (std::thread& worker : mWorkers)
+		worker.join();
+}
+
+// worker thread: take the next file and parse it
+void ObjectLoader::work()
+{
+	for (size_t file = mNextFile++; file < mFiles.size(); file = mNextFile++) {
+		ParsedMesh parsed;
+		parsed.file = file;
+		parsed.mesh = Object::loadMesh(mFiles[file].c_str());
+
+		std::lock_guard<std::mutex> lock(mReadyMutex);
+		mReady.push_back(std::move(parsed));
+	}
+}
+
+// GL thread: create the objects of all meshes parsed so far, objects keep the order of the description list
+int ObjectLoader::uploadReady(std::vector<Object*>& objects)
+{
+	std::deque<ParsedMesh> ready;
+	{
+		std::lock_guard<std::mutex> lock(mReadyMutex);
+		ready.swap(mReady);
+	}
+
+	if (objects.size() < mObjects.size())
+		objects.resize(mObjects.size(), nullptr);
+
+	int created = 0;
+	for (const ParsedMesh& parsed : ready) {
+		for (size_t i : mFileObjects[parsed.file]) {
+			const Objects& obj = mObjects[i];
+			objects[i] = new Object(obj.file, obj.pos, obj.scaleFactor, obj.index, parsed.mesh);
+			created++;
+		}
+	}
+	mUploadedCount += created;
+	return created;
+}
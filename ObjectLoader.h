@@ -0,0 +1,55 @@
+#ifndef OBJECT_LOADER_H
+#define OBJECT_LOADER_H
+
+#include "Object.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+//For the 3D models
+struct Objects {
+	const char* file;
+	glm::vec3 pos;
+	float scaleFactor;
+	int index;
+};
+
+// Loads the models in two stages: reading and parsing the files (or their mesh caches) runs on worker threads,
+// creating the buffers runs on the GL thread in uploadReady(). Every file is only parsed once, no matter
+// how many objects use it.
+class ObjectLoader {
+public:
+	ObjectLoader(const std::vector<Objects>& objects, unsigned int threadCount);
+	~ObjectLoader();
+
+	int uploadReady(std::vector<Object*>& objects);
+
+	bool isFinished() const { return mUploadedCount == mObjects.size(); }
+	size_t getUploadedCount() const { return mUploadedCount; }
+	size_t getTotalCount() const { return mObjects.size(); }
+
+private:
+	void work();
+
+	struct ParsedMesh {
+		size_t file;
+		QuantizedMesh mesh;
+	};
+
+	std::vector<Objects> mObjects;
+	std::vector<std::string> mFiles;					// unique files, the jobs of the workers
+	std::vector<std::vector<size_t>> mFileObjects;		// objects using each file
+
+	std::vector<std::thread> mWorkers;
+	std::atomic<size_t> mNextFile;
+	std::mutex mReadyMutex;
+	std::deque<ParsedMesh> mReady;						// parsed on a worker, waiting for upload
+	size_t mUploadedCount = 0;
+};
+
+#endif
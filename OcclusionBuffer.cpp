@@ -0,0 +1,183 @@
+#include "OcclusionBuffer.h"
+
+#include <xmmintrin.h>
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace glm;
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+{
+	mTilesX = std::max(1, width / TILE_SIZE);
+	mTilesY = std::max(1, height / TILE_SIZE);
+	mWidth = mTilesX * TILE_SIZE;
+	mHeight = mTilesY * TILE_SIZE;
+	mDepth.resize(mWidth * mHeight);
+	mTileMaxDepth.resize(mTilesX * mTilesY);
+	mViewProjection = mat4(1.0f);
+}
+
+// clear to the far plane, the occluders of this view follow
+void OcclusionBuffer::begin(const mat4& viewProjection)
+{
+	mViewProjection = viewProjection;
+	std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void OcclusionBuffer::renderOccluder(const mat4& modelMatrix, const std::vector<vec3>& positions, const std::vector<uint32_t>& indices)
+{
+	mat4 modelViewProjection = mViewProjection * modelMatrix;
+	mClipPositions.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+		mClipPositions[i] = modelViewProjection * vec4(positions[i], 1.0f);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		drawTriangle(mClipPositions[indices[i]], mClipPositions[indices[i + 1]], mClipPositions[indices[i + 2]]);
+}
+
+// farthest depth of every tile
+void OcclusionBuffer::end()
+{
+	for (int ty = 0; ty < mTilesY; ty++)
+		for (int tx = 0; tx < mTilesX; tx++) {
+			__m128 farthest = _mm_setzero_ps();
+			for (int y = 0; y < TILE_SIZE; y++) {
+				const float* row = &mDepth[(ty * TILE_SIZE + y) * mWidth + tx * TILE_SIZE];
+				farthest = _mm_max_ps(farthest, _mm_max_ps(_mm_loadu_ps(row), _mm_loadu_ps(row + 4)));
+			}
+			float lanes[4];
+			_mm_storeu_ps(lanes, farthest);
+			mTileMaxDepth[ty * mTilesX + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+}
+
+// clip against the near plane (z >= -w), which leaves a triangle or a quad
+void OcclusionBuffer::drawTriangle(const vec4& a, const vec4& b, const vec4& c)
+{
+	const vec4 input[3] = { a, b, c };
+	vec4 polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++) {
+		const vec4& from = input[i];
+		const vec4& to = input[(i + 1) % 3];
+		float fromDistance = from.z + from.w;
+		float toDistance = to.z + to.w;
+		if (fromDistance >= 0.0f)
+			polygon[count++] = from;
+		if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+			polygon[count++] = from + (to - from) * (fromDistance / (fromDistance - toDistance));
+	}
+	if (count < 3)
+		return;
+
+	vec3 screen[4];
+	for (int i = 0; i < count; i++) {
+		float inverseW = 1.0f / polygon[i].w;
+		screen[i] = vec3((polygon[i].x * inverseW * 0.5f + 0.5f) * mWidth,
+			(polygon[i].y * inverseW * 0.5f + 0.5f) * mHeight,
+			polygon[i].z * inverseW);
+	}
+	rasterize(screen[0], screen[1], screen[2]);
+	if (count == 4)
+		rasterize(screen[0], screen[2], screen[3]);
+}
+
+// pixel centers inside all three edges are covered, the depth is interpolated linearly in screen space
+void OcclusionBuffer::rasterize(vec3 a, vec3 b, vec3 c)
+{
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (fabsf(area) < 1e-6f)
+		return;
+	if (area < 0.0f) {
+		std::swap(b, c);
+		area = -area;
+	}
+
+	int minX = std::max(0, static_cast<int>(floorf(std::min(a.x, std::min(b.x, c.x)))));
+	int maxX = std::min(mWidth - 1, static_cast<int>(ceilf(std::max(a.x, std::max(b.x, c.x)))));
+	int minY = std::max(0, static_cast<int>(floorf(std::min(a.y, std::min(b.y, c.y)))));
+	int maxY = std::min(mHeight - 1, static_cast<int>(ceilf(std::max(a.y, std::max(b.y, c.y)))));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	// edge functions and depth as planes in x and y
+	const vec3* vertices[3] = { &a, &b, &c };
+	__m128 edgeX[3], edgeY[3], edgeConstant[3];
+	for (int i = 0; i < 3; i++) {
+		const vec3& from = *vertices[(i + 1) % 3];
+		const vec3& to = *vertices[(i + 2) % 3];
+		float dx = -(to.y - from.y);
+		float dy = to.x - from.x;
+		edgeX[i] = _mm_set1_ps(dx);
+		edgeY[i] = _mm_set1_ps(dy);
+		edgeConstant[i] = _mm_set1_ps(-(dx * from.x + dy * from.y));
+	}
+	float depthDx = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+	float depthDy = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+	__m128 depthX = _mm_set1_ps(depthDx);
+	__m128 depthY = _mm_set1_ps(depthDy);
+	__m128 depthConstant = _mm_set1_ps(a.z - depthDx * a.x - depthDy * a.y);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	int startX = minX & ~3;
+	for (int y = minY; y <= maxY; y++) {
+		__m128 py = _mm_set1_ps(y + 0.5f);
+		float* row = &mDepth[y * mWidth];
+		for (int x = startX; x <= maxX; x += 4) {
+			__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (int i = 0; i < 3; i++) {
+				__m128 edge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeX[i], px), _mm_mul_ps(edgeY[i], py)), edgeConstant[i]);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+			}
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(depthX, px), _mm_mul_ps(depthY, py)), depthConstant);
+			__m128 stored = _mm_loadu_ps(row + x);
+			__m128 write = _mm_and_ps(inside, _mm_cmplt_ps(depth, stored));
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(write, depth), _mm_andnot_ps(write, stored)));
+		}
+	}
+}
+
+bool OcclusionBuffer::isVisible(const vec3& boundsMin, const vec3& boundsMax) const
+{
+	// screen rectangle and nearest depth of the box corners
+	vec2 screenMin = vec2(FLT_MAX);
+	vec2 screenMax = vec2(-FLT_MAX);
+	float nearestDepth = FLT_MAX;
+	for (int i = 0; i < 8; i++) {
+		vec3 corner = vec3(i & 1 ? boundsMax.x : boundsMin.x, i & 2 ? boundsMax.y : boundsMin.y, i & 4 ? boundsMax.z : boundsMin.z);
+		vec4 clip = mViewProjection * vec4(corner, 1.0f);
+		if (clip.z < -clip.w)
+			return true;					// crosses the near plane
+		vec3 ndc = vec3(clip) / clip.w;
+		screenMin = min(screenMin, vec2(ndc.x, ndc.y));
+		screenMax = max(screenMax, vec2(ndc.x, ndc.y));
+		nearestDepth = std::min(nearestDepth, ndc.z);
+	}
+
+	int minX = std::max(0, static_cast<int>(floorf((screenMin.x * 0.5f + 0.5f) * mWidth)));
+	int maxX = std::min(mWidth - 1, static_cast<int>(floorf((screenMax.x * 0.5f + 0.5f) * mWidth)));
+	int minY = std::max(0, static_cast<int>(floorf((screenMin.y * 0.5f + 0.5f) * mHeight)));
+	int maxY = std::min(mHeight - 1, static_cast<int>(floorf((screenMax.y * 0.5f + 0.5f) * mHeight)));
+	if (minX > maxX || minY > maxY)
+		return true;						// off screen, left to the frustum test
+
+	for (int ty = minY / TILE_SIZE; ty <= maxY / TILE_SIZE; ty++)
+		for (int tx = minX / TILE_SIZE; tx <= maxX / TILE_SIZE; tx++) {
+			if (nearestDepth > mTileMaxDepth[ty * mTilesX + tx])
+				continue;					// everything in the tile is closer
+
+			int x0 = std::max(minX, tx * TILE_SIZE), x1 = std::min(maxX, tx * TILE_SIZE + TILE_SIZE - 1);
+			int y0 = std::max(minY, ty * TILE_SIZE), y1 = std::min(maxY, ty * TILE_SIZE + TILE_SIZE - 1);
+			for (int y = y0; y <= y1; y++)
+				for (int x = x0; x <= x1; x++)
+					if (nearestDepth <= mDepth[y * mWidth + x])
+						return true;
+		}
+	return false;
+}
@@ -0,0 +1,43 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
+
+// Small software depth buffer for occlusion culling. Coarse occluders are rasterized on the CPU, four pixels per
+// SSE step, then the farthest depth of every 8x8 tile is kept as a hierarchical depth level. Bounds are tested
+// against the tiles first and only against single pixels where a tile is not decisive.
+// Depth is the normalized device z of the OpenGL projection, so smaller is closer.
+class OcclusionBuffer {
+public:
+	static const int TILE_SIZE = 8;
+
+	OcclusionBuffer(int width, int height);
+
+	void begin(const glm::mat4& viewProjection);
+	void renderOccluder(const glm::mat4& modelMatrix, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+	void end();
+
+	// false if the world space box is completely behind the occluders
+	bool isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+	int getWidth() const { return mWidth; }
+	int getHeight() const { return mHeight; }
+	const float* getDepth() const { return mDepth.data(); }
+
+private:
+	void drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	void rasterize(glm::vec3 a, glm::vec3 b, glm::vec3 c);
+
+	int mWidth;						// multiples of TILE_SIZE
+	int mHeight;
+	int mTilesX;
+	int mTilesY;
+	glm::mat4 mViewProjection;
+	std::vector<float> mDepth;			// rows from bottom to top
+	std::vector<float> mTileMaxDepth;
+	std::vector<glm::vec4> mClipPositions;
+};
+
+#endif
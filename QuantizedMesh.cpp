@@ -0,0 +1,255 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "QuantizedMesh.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace glm;
+
+static const char MESH_MAGIC[4] = { 'Q', 'M', 'S', 'H' };
+static const uint32_t MESH_VERSION = 4;
+
+// header of the binary cache file, followed by the position, normal, texcoord, index and lod arrays
+struct QuantizedMeshHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceSize;
+	uint64_t sourceTime;		// modification time of the source file
+	uint32_t vertexCount;
+	float boundsMin[3];
+	float boundsExtent[3];
+	uint32_t indexCount;
+	uint32_t lodCount;
+};
+
+QuantizedMesh::QuantizedMesh(const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec2>& texCoords,
+	const std::vector<uint32_t>& indices, const std::vector<Lod>& lods) :
+	mIndices(indices),
+	mLods(lods)
+{
+	mVertexCount = static_cast<unsigned int>(positions.size());
+
+	// axis aligned bounding box, positions are stored relative to it
+	vec3 boundsMax = mVertexCount > 0 ? positions[0] : vec3(0.0f);
+	mBoundsMin = boundsMax;
+	for (const vec3& p : positions) {
+		mBoundsMin = min(mBoundsMin, p);
+		boundsMax = max(boundsMax, p);
+	}
+	mBoundsExtent = boundsMax - mBoundsMin;
+	for (int i = 0; i < 3; i++)
+		if (mBoundsExtent[i] <= 0.0f)
+			mBoundsExtent[i] = 1.0f;		// flat meshes, avoid division by zero
+
+	mPositions.reserve(mVertexCount * 4);
+	for (const vec3& p : positions) {
+		vec3 unorm = (p - mBoundsMin) / mBoundsExtent;
+		for (int i = 0; i < 3; i++)
+			mPositions.push_back(static_cast<uint16_t>(std::min(std::max(unorm[i], 0.0f), 1.0f) * 65535.0f + 0.5f));
+		mPositions.push_back(0);			// padding, keeps every vertex 8 byte aligned
+	}
+
+	mNormals.reserve(mVertexCount * 2);
+	for (const vec3& n : normals) {
+		vec2 encoded = octEncode(n);
+		mNormals.push_back(static_cast<int16_t>(floorf(std::min(std::max(encoded.x, -1.0f), 1.0f) * 32767.0f + 0.5f)));
+		mNormals.push_back(static_cast<int16_t>(floorf(std::min(std::max(encoded.y, -1.0f), 1.0f) * 32767.0f + 0.5f)));
+	}
+
+	mTexCoords.reserve(mVertexCount * 2);
+	for (const vec2& t : texCoords) {
+		mTexCoords.push_back(floatToHalf(t.x));
+		mTexCoords.push_back(floatToHalf(t.y));
+	}
+}
+
+// position of a vertex in object space
+vec3 QuantizedMesh::getPosition(unsigned int vertex) const
+{
+	vec3 unorm = vec3(mPositions[4 * vertex + 0], mPositions[4 * vertex + 1], mPositions[4 * vertex + 2]) / 65535.0f;
+	return mBoundsMin + unorm * mBoundsExtent;
+}
+
+// read a cache file, fails if it is missing, outdated or was written for a different source file
+bool QuantizedMesh::load(const std::string& path, uint64_t sourceSize, uint64_t sourceTime)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+		return false;
+
+	QuantizedMeshHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) == 0
+		&& header.version == MESH_VERSION
+		&& header.sourceSize == sourceSize
+		&& header.sourceTime == sourceTime;
+
+	if (valid) {
+		mVertexCount = header.vertexCount;
+		mBoundsMin = vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		mBoundsExtent = vec3(header.boundsExtent[0], header.boundsExtent[1], header.boundsExtent[2]);
+		mPositions.resize(mVertexCount * 4);
+		mNormals.resize(mVertexCount * 2);
+		mTexCoords.resize(mVertexCount * 2);
+		mIndices.resize(header.indexCount);
+		mLods.resize(header.lodCount);
+		valid = fread(mPositions.data(), sizeof(uint16_t), mPositions.size(), file) == mPositions.size()
+			&& fread(mNormals.data(), sizeof(int16_t), mNormals.size(), file) == mNormals.size()
+			&& fread(mTexCoords.data(), sizeof(uint16_t), mTexCoords.size(), file) == mTexCoords.size()
+			&& fread(mIndices.data(), sizeof(uint32_t), mIndices.size(), file) == mIndices.size()
+			&& fread(mLods.data(), sizeof(Lod), mLods.size(), file) == mLods.size();
+	}
+	fclose(file);
+	return valid;
+}
+
+// read a cache file that is already in memory, e.g. inside an asset pack
+bool QuantizedMesh::read(const char* data, size_t size)
+{
+	QuantizedMeshHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) != 0 || header.version != MESH_VERSION)
+		return false;
+
+	size_t positionsSize = header.vertexCount * 4 * sizeof(uint16_t);
+	size_t normalsSize = header.vertexCount * 2 * sizeof(int16_t);
+	size_t texCoordsSize = header.vertexCount * 2 * sizeof(uint16_t);
+	size_t indicesSize = header.indexCount * sizeof(uint32_t);
+	size_t lodsSize = header.lodCount * sizeof(Lod);
+	if (size < sizeof(header) + positionsSize + normalsSize + texCoordsSize + indicesSize + lodsSize)
+		return false;
+
+	mVertexCount = header.vertexCount;
+	mBoundsMin = vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	mBoundsExtent = vec3(header.boundsExtent[0], header.boundsExtent[1], header.boundsExtent[2]);
+	mPositions.resize(mVertexCount * 4);
+	mNormals.resize(mVertexCount * 2);
+	mTexCoords.resize(mVertexCount * 2);
+	mIndices.resize(header.indexCount);
+	mLods.resize(header.lodCount);
+	data += sizeof(header);
+	memcpy(mPositions.data(), data, positionsSize);
+	data += positionsSize;
+	memcpy(mNormals.data(), data, normalsSize);
+	data += normalsSize;
+	memcpy(mTexCoords.data(), data, texCoordsSize);
+	data += texCoordsSize;
+	memcpy(mIndices.data(), data, indicesSize);
+	data += indicesSize;
+	memcpy(mLods.data(), data, lodsSize);
+	return true;
+}
+
+bool QuantizedMesh::save(const std::string& path, uint64_t sourceSize, uint64_t sourceTime) const
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		printf("Unable to write mesh cache %s\n", path.c_str());
+		return false;
+	}
+
+	QuantizedMeshHeader header;
+	memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+	header.version = MESH_VERSION;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.vertexCount = mVertexCount;
+	header.indexCount = static_cast<uint32_t>(mIndices.size());
+	header.lodCount = static_cast<uint32_t>(mLods.size());
+	for (int i = 0; i < 3; i++) {
+		header.boundsMin[i] = mBoundsMin[i];
+		header.boundsExtent[i] = mBoundsExtent[i];
+	}
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(mPositions.data(), sizeof(uint16_t), mPositions.size(), file) == mPositions.size()
+		&& fwrite(mNormals.data(), sizeof(int16_t), mNormals.size(), file) == mNormals.size()
+		&& fwrite(mTexCoords.data(), sizeof(uint16_t), mTexCoords.size(), file) == mTexCoords.size()
+		&& fwrite(mIndices.data(), sizeof(uint32_t), mIndices.size(), file) == mIndices.size()
+		&& fwrite(mLods.data(), sizeof(Lod), mLods.size(), file) == mLods.size();
+	fclose(file);
+	return written;
+}
+
+// IEEE 754 single to half precision, round to nearest
+uint16_t QuantizedMesh::floatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x007fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff)						// inf or nan
+		return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	if (exponent >= 31)										// too large, clamp to inf
+		return static_cast<uint16_t>(sign | 0x7c00);
+	if (exponent <= 0) {									// denormal half or zero
+		if (exponent < -10)
+			return static_cast<uint16_t>(sign);
+		mantissa |= 0x00800000;
+		uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			half++;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)									// a carry into the exponent is still correct
+		half++;
+	return static_cast<uint16_t>(half);
+}
+
+float QuantizedMesh::halfToFloat(uint16_t value)
+{
+	uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+	uint32_t bits;
+
+	if (exponent == 0) {
+		float denormal = ldexpf(static_cast<float>(mantissa), -24);
+		return sign ? -denormal : denormal;
+	}
+	if (exponent == 31)
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+// project the unit normal onto the octahedron and unfold the lower half, result is in [-1, 1]^2
+vec2 QuantizedMesh::octEncode(const vec3& normal)
+{
+	float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (l1 <= 0.0f)
+		return vec2(0.0f);
+
+	vec2 p = vec2(normal.x, normal.y) / l1;
+	if (normal.z < 0.0f) {
+		vec2 folded = vec2(1.0f - fabsf(p.y), 1.0f - fabsf(p.x));
+		p = vec2(p.x >= 0.0f ? folded.x : -folded.x, p.y >= 0.0f ? folded.y : -folded.y);
+	}
+	return p;
+}
+
+vec3 QuantizedMesh::octDecode(const vec2& encoded)
+{
+	vec3 n = vec3(encoded.x, encoded.y, 1.0f - fabsf(encoded.x) - fabsf(encoded.y));
+	if (n.z < 0.0f) {
+		vec2 folded = vec2(1.0f - fabsf(n.y), 1.0f - fabsf(n.x));
+		n.x = n.x >= 0.0f ? folded.x : -folded.x;
+		n.y = n.y >= 0.0f ? folded.y : -folded.y;
+	}
+	return normalize(n);
+}
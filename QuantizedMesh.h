@@ -0,0 +1,53 @@
+#ifndef QUANTIZED_MESH_H
+#define QUANTIZED_MESH_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// Compressed vertex data of a static mesh, also used as binary cache format next to the OBJ files.
+// positions: 16-bit unsigned normalized relative to the mesh AABB (x, y, z, padding)
+// normals:   octahedral encoded, 2x16-bit signed normalized
+// texcoords: 2x half float
+// indices:   32-bit, the levels of detail are consecutive ranges of the index array, finest first
+class QuantizedMesh {
+public:
+	// range of the index array and the largest distance of the simplified vertices to the original planes in object space units
+	struct Lod {
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		float error;
+	};
+
+	QuantizedMesh() = default;
+	QuantizedMesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals, const std::vector<glm::vec2>& texCoords,
+		const std::vector<uint32_t>& indices, const std::vector<Lod>& lods);
+
+	bool load(const std::string& path, uint64_t sourceSize, uint64_t sourceTime);
+	bool read(const char* data, size_t size);
+	bool save(const std::string& path, uint64_t sourceSize, uint64_t sourceTime) const;
+
+	unsigned int getVertexCount() const { return mVertexCount; }
+	const glm::vec3& getBoundsMin() const { return mBoundsMin; }
+	const glm::vec3& getBoundsExtent() const { return mBoundsExtent; }
+	glm::vec3 getPosition(unsigned int vertex) const;
+
+	static uint16_t floatToHalf(float value);
+	static float halfToFloat(uint16_t value);
+	static glm::vec2 octEncode(const glm::vec3& normal);
+	static glm::vec3 octDecode(const glm::vec2& encoded);
+
+	std::vector<uint16_t> mPositions;
+	std::vector<int16_t> mNormals;
+	std::vector<uint16_t> mTexCoords;
+	std::vector<uint32_t> mIndices;
+	std::vector<Lod> mLods;
+
+private:
+	unsigned int mVertexCount = 0;
+	glm::vec3 mBoundsMin = glm::vec3(0.0f);
+	glm::vec3 mBoundsExtent = glm::vec3(1.0f);
+};
+
+#endif
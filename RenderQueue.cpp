@@ -0,0 +1,44 @@
+#include "RenderQueue.h"
+#include "SimpleShaders.h"
+
+#include <algorithm>
+
+uint64_t RenderQueue::makeKey(Layer layer, float depth, float maxDepth, unsigned int program, unsigned int texture, unsigned int mesh)
+{
+	float normalized = std::min(std::max(depth / maxDepth, 0.0f), 1.0f);
+	uint64_t fineDepth = static_cast<uint64_t>(normalized * 0xffffff);
+	uint64_t coarseDepth = fineDepth >> 18;
+	return (static_cast<uint64_t>(layer & 0x3) << 62)
+		| (coarseDepth << 56)
+		| (static_cast<uint64_t>(program & 0xff) << 48)
+		| (static_cast<uint64_t>(texture & 0xfff) << 36)
+		| (fineDepth << 12)
+		| static_cast<uint64_t>(mesh & 0xfff);
+}
+
+void RenderQueue::clear()
+{
+	mPackets.clear();
+}
+
+void RenderQueue::add(uint64_t key, SimpleShaders* shaders, void (*draw)(void*), void* element)
+{
+	DrawPacket packet = { key, shaders, draw, element };
+	mPackets.push_back(packet);
+}
+
+void RenderQueue::submit()
+{
+	std::sort(mPackets.begin(), mPackets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+
+	mShaderChanges = 0;
+	SimpleShaders* active = nullptr;
+	for (const DrawPacket& packet : mPackets) {
+		if (packet.shaders != active) {
+			packet.shaders->activate();
+			active = packet.shaders;
+			mShaderChanges++;
+		}
+		packet.draw(packet.element);
+	}
+}
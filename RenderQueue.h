@@ -0,0 +1,44 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+class SimpleShaders;
+
+// one draw call, recorded while the scene is traversed and issued after sorting
+struct DrawPacket {
+	uint64_t key;
+	SimpleShaders* shaders;					// program and textures, activated when it differs from the previous packet
+	void (*draw)(void* element);			// sets the per draw uniforms and draws
+	void* element;
+};
+
+// Collects the draw calls of a pass and submits them ordered by a 64-bit key, from the most significant bits:
+//  2 layer          opaque geometry before the skybox
+//  6 coarse depth   front to back in large steps, so that early-Z rejects hidden fragments
+//  8 program        inside a depth step, draws with the same shaders and textures are grouped
+// 12 texture
+// 24 fine depth     front to back inside a group
+// 12 mesh
+class RenderQueue {
+public:
+	enum Layer { OPAQUE_LAYER, SKY_LAYER };
+
+	// depth is a view distance, clamped to maxDepth
+	static uint64_t makeKey(Layer layer, float depth, float maxDepth, unsigned int program, unsigned int texture, unsigned int mesh);
+
+	void clear();
+	void add(uint64_t key, SimpleShaders* shaders, void (*draw)(void*), void* element);
+	void submit();
+
+	size_t getDrawCount() const { return mPackets.size(); }
+	size_t getShaderChanges() const { return mShaderChanges; }
+
+private:
+	std::vector<DrawPacket> mPackets;
+	size_t mShaderChanges = 0;				// activations in the last submit
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "SceneBVH.h"
+#include "Object.h"
+
+#include <float.h>
+#include <algorithm>
+
+using namespace glm;
+
+static const uint32_t LEAF_SIZE = 4;		// one SSE sphere test per leaf
+static const int STACK_SIZE = 64;			// the tree is balanced, far deeper than needed
+
+void SceneBVH::build(const std::vector<Object*>& objects)
+{
+	mObjects = objects;
+	mNodes.clear();
+	mOrder.resize(mObjects.size());
+	for (uint32_t i = 0; i < mOrder.size(); i++)
+		mOrder[i] = i;
+	if (mObjects.empty())
+		return;
+
+	std::vector<vec3> centers;
+	centers.reserve(mObjects.size());
+	for (Object* object : mObjects)
+		centers.push_back(vec3(object->getBoundingSphere()));
+
+	mNodes.reserve(2 * mObjects.size() / LEAF_SIZE + 1);
+	mNodes.push_back(Node());
+	buildNode(0, 0, static_cast<uint32_t>(mObjects.size()), centers);
+
+	mSpheres.clear();
+	for (uint32_t index : mOrder)
+		mSpheres.add(mObjects[index]->getBoundingSphere());
+	for (uint32_t i = 0; i < LEAF_SIZE - 1; i++)
+		mSpheres.add(vec4(0.0f, 0.0f, 0.0f, -1.0f));
+	mChanged.assign(mNodes.size(), 1);
+	updateBounds();
+}
+
+// new objects change the tree structure, so the whole tree is rebuilt
+void SceneBVH::insert(Object* object)
+{
+	std::vector<Object*> objects = mObjects;
+	objects.push_back(object);
+	build(objects);
+}
+
+void SceneBVH::buildNode(uint32_t node, uint32_t first, uint32_t count, const std::vector<vec3>& centers)
+{
+	mNodes[node].first = first;
+	mNodes[node].count = count;
+	mNodes[node].children = 0;
+	if (count <= LEAF_SIZE)
+		return;
+
+	vec3 centersMin = centers[mOrder[first]];
+	vec3 centersMax = centersMin;
+	for (uint32_t i = first; i < first + count; i++) {
+		centersMin = min(centersMin, centers[mOrder[i]]);
+		centersMax = max(centersMax, centers[mOrder[i]]);
+	}
+	vec3 extent = centersMax - centersMin;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	uint32_t middle = first + count / 2;
+	std::nth_element(mOrder.begin() + first, mOrder.begin() + middle, mOrder.begin() + first + count,
+		[&](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; });
+
+	uint32_t children = static_cast<uint32_t>(mNodes.size());
+	mNodes[node].children = children;
+	mNodes.push_back(Node());
+	mNodes.push_back(Node());
+	buildNode(children, first, middle - first, centers);
+	buildNode(children + 1, middle, first + count - middle, centers);
+}
+
+// the objects cache their spheres until they move, so comparing them is cheap. Only leaves with a changed sphere are marked.
+void SceneBVH::refit()
+{
+	mChanged.assign(mNodes.size(), 0);
+	for (size_t i = 0; i < mNodes.size(); i++) {
+		const Node& node = mNodes[i];
+		if (node.children != 0)
+			continue;
+		for (uint32_t j = node.first; j < node.first + node.count; j++) {
+			vec4 sphere = mObjects[mOrder[j]]->getBoundingSphere();
+			if (sphere.x == mSpheres.x[j] && sphere.y == mSpheres.y[j] && sphere.z == mSpheres.z[j] && sphere.w == mSpheres.radius[j])
+				continue;
+			mSpheres.x[j] = sphere.x;
+			mSpheres.y[j] = sphere.y;
+			mSpheres.z[j] = sphere.z;
+			mSpheres.radius[j] = sphere.w;
+			mChanged[i] = 1;
+		}
+	}
+	updateBounds();
+}
+
+// children are always stored after their parent, so one backwards pass updates the marked leaves and their ancestors bottom up
+void SceneBVH::updateBounds()
+{
+	for (size_t i = mNodes.size(); i-- > 0;) {
+		Node& node = mNodes[i];
+		if (node.children != 0 && (mChanged[node.children] || mChanged[node.children + 1]))
+			mChanged[i] = 1;
+		if (!mChanged[i])
+			continue;
+
+		if (node.children == 0) {
+			node.boundsMin = vec3(FLT_MAX);
+			node.boundsMax = vec3(-FLT_MAX);
+			for (uint32_t j = node.first; j < node.first + node.count; j++) {
+				vec3 center = vec3(mSpheres.x[j], mSpheres.y[j], mSpheres.z[j]);
+				node.boundsMin = min(node.boundsMin, center - vec3(mSpheres.radius[j]));
+				node.boundsMax = max(node.boundsMax, center + vec3(mSpheres.radius[j]));
+			}
+		}
+		else {
+			node.boundsMin = min(mNodes[node.children].boundsMin, mNodes[node.children + 1].boundsMin);
+			node.boundsMax = max(mNodes[node.children].boundsMax, mNodes[node.children + 1].boundsMax);
+		}
+	}
+}
+
+size_t SceneBVH::cull(const Frustum& frustum, std::vector<unsigned char>& visible) const
+{
+	visible.assign(mObjects.size(), 0);
+	if (mNodes.empty())
+		return 0;
+
+	size_t visibleCount = 0;
+	uint32_t stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const Node& node = mNodes[stack[--stackSize]];
+		Frustum::Intersection intersection = frustum.intersect(node.boundsMin, node.boundsMax);
+		if (intersection == Frustum::OUTSIDE)
+			continue;
+
+		// everything below a node inside the frustum is visible without further tests
+		if (intersection == Frustum::INSIDE) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+				visible[mOrder[i]] = 1;
+			visibleCount += node.count;
+		}
+		else if (node.children == 0) {
+			unsigned int mask = frustum.testSpheres(&mSpheres.x[node.first], &mSpheres.y[node.first], &mSpheres.z[node.first], &mSpheres.radius[node.first]);
+			for (uint32_t i = 0; i < node.count; i++)
+				if (mask & (1u << i)) {
+					visible[mOrder[node.first + i]] = 1;
+					visibleCount++;
+				}
+		}
+		else {
+			stack[stackSize++] = node.children;
+			stack[stackSize++] = node.children + 1;
+		}
+	}
+	return visibleCount;
+}
+
+// slab test, returns the ray parameter where the box is entered (0 if the origin is inside)
+static bool intersectBox(const vec3& origin, const vec3& inverseDirection, const vec3& boundsMin, const vec3& boundsMax, float& entry)
+{
+	vec3 t0 = (boundsMin - origin) * inverseDirection;
+	vec3 t1 = (boundsMax - origin) * inverseDirection;
+	vec3 tMin = min(t0, t1);
+	vec3 tMax = max(t0, t1);
+	float tNear = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+	float tFar = std::min(std::min(tMax.x, tMax.y), tMax.z);
+	entry = tNear;
+	return tNear <= tFar;
+}
+
+static vec3 inverse(const vec3& direction)
+{
+	// a huge value instead of infinity, so that 0 * inverse stays a number
+	return vec3(direction.x != 0.0f ? 1.0f / direction.x : FLT_MAX,
+		direction.y != 0.0f ? 1.0f / direction.y : FLT_MAX,
+		direction.z != 0.0f ? 1.0f / direction.z : FLT_MAX);
+}
+
+int SceneBVH::raycast(const vec3& origin, const vec3& direction, float& distance) const
+{
+	distance = FLT_MAX;
+	int hit = -1;
+	if (mNodes.empty())
+		return hit;
+
+	vec3 inverseDirection = inverse(direction);
+	uint32_t stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const Node& node = mNodes[stack[--stackSize]];
+		float entry;
+		if (!intersectBox(origin, inverseDirection, node.boundsMin, node.boundsMax, entry) || entry >= distance)
+			continue;
+
+		if (node.children != 0) {
+			stack[stackSize++] = node.children;
+			stack[stackSize++] = node.children + 1;
+			continue;
+		}
+
+		// exact test against the object space box, the ray parameter is the same in both spaces
+		for (uint32_t i = node.first; i < node.first + node.count; i++) {
+			Object* object = mObjects[mOrder[i]];
+			mat4 toObject = glm::inverse(object->getModelMatrix());
+			vec3 objectOrigin = vec3(toObject * vec4(origin, 1.0f));
+			vec3 objectDirection = vec3(toObject * vec4(direction, 0.0f));
+			if (intersectBox(objectOrigin, inverse(objectDirection), object->getBoundsMin(), object->getBoundsMin() + object->getBoundsExtent(), entry)
+				&& entry < distance) {
+				distance = entry;
+				hit = static_cast<int>(mOrder[i]);
+			}
+		}
+	}
+	return hit;
+}
+
+void SceneBVH::query(const vec3& center, float radius, std::vector<int>& result) const
+{
+	result.clear();
+	if (mNodes.empty())
+		return;
+
+	uint32_t stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const Node& node = mNodes[stack[--stackSize]];
+		vec3 closest = min(max(center, node.boundsMin), node.boundsMax);
+		vec3 offset = closest - center;
+		if (dot(offset, offset) > radius * radius)
+			continue;
+
+		if (node.children != 0) {
+			stack[stackSize++] = node.children;
+			stack[stackSize++] = node.children + 1;
+			continue;
+		}
+
+		for (uint32_t i = node.first; i < node.first + node.count; i++) {
+			vec3 toSphere = vec3(mSpheres.x[i], mSpheres.y[i], mSpheres.z[i]) - center;
+			float reach = radius + mSpheres.radius[i];
+			if (dot(toSphere, toSphere) <= reach * reach)
+				result.push_back(static_cast<int>(mOrder[i]));
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+#include "Frustum.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
+
+class Object;
+
+// Bounding volume hierarchy over the scene objects, queries visit O(log n) nodes.
+// build() sorts the objects into a binary tree of boxes around their bounding spheres, splitting at the median
+// along the longest axis. refit() only updates the leaves of objects whose bounding sphere changed and their ancestors,
+// the tree stays valid but gets looser the further objects travel from where they were when it was built.
+// All queries return indices into the objects vector given to build().
+class SceneBVH {
+public:
+	void build(const std::vector<Object*>& objects);
+	void insert(Object* object);
+	void refit();
+
+	// visible[i] is set to 1 if object i intersects the frustum, returns the number of visible objects
+	size_t cull(const Frustum& frustum, std::vector<unsigned char>& visible) const;
+	// nearest object whose box is hit by the ray, -1 if there is none. distance is in units of direction.
+	int raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+	// objects whose bounding sphere intersects the given sphere
+	void query(const glm::vec3& center, float radius, std::vector<int>& result) const;
+
+	size_t getNodeCount() const { return mNodes.size(); }
+
+private:
+	// leaves have no children, every node covers a contiguous range of mOrder
+	struct Node {
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		uint32_t first;
+		uint32_t count;
+		uint32_t children;		// index of the left child, the right one follows it, 0 for leaves
+	};
+
+	void buildNode(uint32_t node, uint32_t first, uint32_t count, const std::vector<glm::vec3>& centers);
+	void updateBounds();
+
+	std::vector<Object*> mObjects;
+	std::vector<uint32_t> mOrder;		// object indices sorted by leaf
+	std::vector<Node> mNodes;
+	SphereBatch mSpheres;				// bounding spheres in leaf order, padded so that every leaf can load four
+	std::vector<unsigned char> mChanged;	// per node, set if its box has to be recomputed
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "SceneUniforms.h"
+#include "SimpleShaders.h"
+
+#include <stdio.h>
+
+static_assert(sizeof(SceneUniforms::PerFrame) == 32, "PerFrame does not match the std140 layout");
+static_assert(sizeof(SceneUniforms::PerPass) == 3 * 64 + 2 * 16, "PerPass does not match the std140 layout");
+
+SceneUniforms::SceneUniforms(int passCount) :
+	mPassCount(passCount)
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	mPassStride = (static_cast<GLint>(sizeof(PerPass)) + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &mFrameBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mFrameBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(PerFrame), NULL, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &mPassBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mPassBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, mPassStride * passCount, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, PER_FRAME_BINDING, mFrameBuffer);
+}
+
+SceneUniforms::~SceneUniforms()
+{
+	glDeleteBuffers(1, &mFrameBuffer);
+	glDeleteBuffers(1, &mPassBuffer);
+}
+
+void SceneUniforms::setFrame(const PerFrame& frame)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, mFrameBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PerFrame), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SceneUniforms::setPass(int pass, const PerPass& data)
+{
+	if (pass < 0 || pass >= mPassCount) {
+		printf("[SceneUniforms] Pass %d out of range\n", pass);
+		return;
+	}
+	GLintptr offset = static_cast<GLintptr>(pass) * mPassStride;
+	glBindBuffer(GL_UNIFORM_BUFFER, mPassBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(PerPass), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferRange(GL_UNIFORM_BUFFER, PER_PASS_BINDING, mPassBuffer, offset, sizeof(PerPass));
+}
+
+bool SceneUniforms::checkBlocks(const SimpleShaders& shaders) const
+{
+	GLint frameSize = shaders.getBlockSize("PerFrame");
+	GLint passSize = shaders.getBlockSize("PerPass");
+	bool valid = frameSize <= static_cast<GLint>(sizeof(PerFrame)) && passSize <= static_cast<GLint>(sizeof(PerPass));
+	if (!valid)
+		printf("[SceneUniforms] Uniform blocks of program %u are %d and %d bytes, expected %zu and %zu\n", shaders.getProgram(),
+			frameSize, passSize, sizeof(PerFrame), sizeof(PerPass));
+	return valid;
+}
@@ -0,0 +1,50 @@
+#ifndef SCENE_UNIFORMS_H
+#define SCENE_UNIFORMS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class SimpleShaders;
+
+// Uniform buffers with the constants every program reads, uploaded once per frame and once per render pass instead
+// of per program. The layouts match the std140 blocks PerFrame and PerPass declared in the shaders.
+class SceneUniforms {
+public:
+	enum Binding { PER_FRAME_BINDING = 0, PER_PASS_BINDING = 1 };
+
+	struct PerFrame {
+		glm::vec3 worldSunDirection;
+		float waterHeight;
+		float time;							// seconds since start
+		float causticTime;					// caustic animation time in frames
+		float padding[2];
+	};
+
+	struct PerPass {
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 inverseView;
+		glm::vec4 clipPlane;
+		glm::vec3 cameraPosition;
+		float padding;
+	};
+
+	// every pass of a frame gets its own range of the pass buffer, so that a pass does not overwrite data a
+	// previous one is still drawn with
+	explicit SceneUniforms(int passCount);
+	~SceneUniforms();
+
+	void setFrame(const PerFrame& frame);
+	void setPass(int pass, const PerPass& data);		// also binds the range of the pass
+
+	// reports blocks of the program that are larger than the structs, i.e. declared differently in the shader
+	bool checkBlocks(const SimpleShaders& shaders) const;
+
+private:
+	GLuint mFrameBuffer = 0;
+	GLuint mPassBuffer = 0;
+	GLint mPassStride = 0;
+	int mPassCount;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "ShaderCache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const char* CACHE_DIRECTORY = "ShaderCache";
+static const char CACHE_MAGIC[4] = { 'S', 'P', 'R', 'G' };
+static const uint32_t CACHE_VERSION = 1;
+
+struct ShaderCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;		// binary format of the driver
+	uint32_t length;
+};
+
+// FNV-1a, the terminating zero is hashed as well so that the concatenation of two strings stays unambiguous
+static uint64_t hashString(const char* s, size_t length, uint64_t h)
+{
+	for (size_t i = 0; i <= length; i++) {
+		h ^= i < length ? static_cast<uint8_t>(s[i]) : 0;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+static const char* getDriverString(GLenum name)
+{
+	const char* value = reinterpret_cast<const char*>(glGetString(name));
+	return value != NULL ? value : "";
+}
+
+uint64_t ShaderCache::makeKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	uint64_t h = 14695981039346656037ull;
+	h = hashString(vertexSource.data(), vertexSource.size(), h);
+	h = hashString(fragmentSource.data(), fragmentSource.size(), h);
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		const char* value = getDriverString(name);
+		h = hashString(value, strlen(value), h);
+	}
+	return h;
+}
+
+std::string ShaderCache::getCachePath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return std::string(CACHE_DIRECTORY) + "/" + name;
+}
+
+// some drivers expose the extension without offering a single binary format
+bool ShaderCache::isSupported()
+{
+	if (!GLEW_ARB_get_program_binary)
+		return false;
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+GLuint ShaderCache::load(uint64_t key)
+{
+	if (!isSupported())
+		return 0;
+	std::string path = getCachePath(key);
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+	std::vector<char> content(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(content.data(), content.size());
+
+	ShaderCacheHeader header;
+	if (content.size() < sizeof(header)) {
+		printf("[ShaderCache] %s is invalid\n", path.c_str());
+		return 0;
+	}
+	memcpy(&header, content.data(), sizeof(header));
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION || header.key != key
+		|| content.size() != sizeof(header) + header.length) {
+		printf("[ShaderCache] %s is invalid\n", path.c_str());
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, content.data() + sizeof(header), header.length);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE) {
+		printf("[ShaderCache] %s was rejected by the driver\n", path.c_str());
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ShaderCache::prepare(GLuint program)
+{
+	if (isSupported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+// the program has to be linked successfully
+bool ShaderCache::store(uint64_t key, GLuint program)
+{
+	if (!isSupported())
+		return false;
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, binary.data());
+
+#ifdef _WIN32
+	_mkdir(CACHE_DIRECTORY);
+#else
+	mkdir(CACHE_DIRECTORY, 0755);
+#endif
+	std::string path = getCachePath(key);
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		printf("[ShaderCache] Unable to write %s\n", path.c_str());
+		return false;
+	}
+	ShaderCacheHeader header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.format = format;
+	header.length = static_cast<uint32_t>(written);
+	bool stored = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(binary.data(), 1, written, file) == static_cast<size_t>(written);
+	fclose(file);
+	return stored;
+}
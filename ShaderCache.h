@@ -0,0 +1,28 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <GL/glew.h>
+#include <string>
+#include <stdint.h>
+
+// Linked program binaries in ShaderCache/, so that a start does not compile the GLSL sources again.
+// The file name is a hash of everything a binary depends on: both sources as compiled (including any defines
+// added to them) and the vendor, renderer and version of the driver, a change of any of them gives a new file.
+// A binary the driver rejects is ignored and the program is compiled from source again.
+// Layout: header with the key, binary format and length, then the binary of glGetProgramBinary.
+class ShaderCache {
+public:
+	static uint64_t makeKey(const std::string& vertexSource, const std::string& fragmentSource);
+	static std::string getCachePath(uint64_t key);
+
+	// linked program or 0 if there is no usable binary
+	static GLuint load(uint64_t key);
+	// has to be called before linking a program that is stored afterwards
+	static void prepare(GLuint program);
+	static bool store(uint64_t key, GLuint program);
+
+private:
+	static bool isSupported();
+};
+
+#endif
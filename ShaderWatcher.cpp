@@ -0,0 +1,129 @@
+#include "ShaderWatcher.h"
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+static const int WAIT_MS = 100;			// how often the thread checks whether it has to stop
+static const int POLL_MS = 250;			// interval of the modification time fallback
+
+static std::string getDirectory(const std::string& file)
+{
+	size_t slash = file.find_last_of("/\\");
+	return slash == std::string::npos ? std::string(".") : file.substr(0, slash);
+}
+
+static time_t getModificationTime(const std::string& file)
+{
+	struct stat status;
+	return stat(file.c_str(), &status) == 0 ? status.st_mtime : 0;
+}
+
+ShaderWatcher::ShaderWatcher(const std::vector<std::string>& files) :
+	mFiles(files),
+	mStop(false)
+{
+#ifdef __linux__
+	mInotify = inotify_init1(IN_NONBLOCK);
+	if (mInotify >= 0) {
+		mThread = std::thread(&ShaderWatcher::watchEvents, this);
+		return;
+	}
+	printf("[ShaderWatcher] inotify is not available, polling the modification times\n");
+#endif
+	mThread = std::thread(&ShaderWatcher::pollTimes, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	mStop = true;
+	mThread.join();
+#ifdef __linux__
+	if (mInotify >= 0)
+		close(mInotify);
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::takeChanged()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<std::string> changed;
+	changed.swap(mChanged);
+	return changed;
+}
+
+void ShaderWatcher::markChanged(const std::string& file)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (std::find(mChanged.begin(), mChanged.end(), file) == mChanged.end())
+		mChanged.push_back(file);
+}
+
+// editors either write the file in place or replace it by a renamed temporary file
+void ShaderWatcher::watchEvents()
+{
+#ifdef __linux__
+	std::vector<std::pair<int, std::string>> directories;
+	for (const std::string& file : mFiles) {
+		std::string directory = getDirectory(file);
+		bool watched = false;
+		for (const std::pair<int, std::string>& entry : directories)
+			watched = watched || entry.second == directory;
+		if (watched)
+			continue;
+		int descriptor = inotify_add_watch(mInotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (descriptor < 0)
+			printf("[ShaderWatcher] Unable to watch %s\n", directory.c_str());
+		else
+			directories.push_back(std::make_pair(descriptor, directory));
+	}
+
+	alignas(struct inotify_event) char buffer[4096];
+	while (!mStop) {
+		pollfd descriptor = { mInotify, POLLIN, 0 };
+		if (poll(&descriptor, 1, WAIT_MS) <= 0)
+			continue;
+		ssize_t length = read(mInotify, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < length; ) {
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+			offset += sizeof(struct inotify_event) + event->len;
+			if (event->len == 0)
+				continue;
+			for (const std::pair<int, std::string>& entry : directories) {
+				if (entry.first != event->wd)
+					continue;
+				std::string path = entry.second + "/" + event->name;
+				if (std::find(mFiles.begin(), mFiles.end(), path) != mFiles.end())
+					markChanged(path);
+			}
+		}
+	}
+#endif
+}
+
+void ShaderWatcher::pollTimes()
+{
+	std::vector<time_t> times;
+	for (const std::string& file : mFiles)
+		times.push_back(getModificationTime(file));
+
+	while (!mStop) {
+		for (int waited = 0; waited < POLL_MS && !mStop; waited += WAIT_MS)
+			std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MS));
+		for (size_t i = 0; i < mFiles.size(); i++) {
+			time_t time = getModificationTime(mFiles[i]);
+			if (time != times[i]) {
+				times[i] = time;
+				markChanged(mFiles[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// Watches the shader files on a background thread and collects the ones that were written, the GL thread picks
+// them up with takeChanged() and reloads the programs using them. On Linux the directories of the files are
+// watched with inotify, elsewhere (or if inotify fails) the modification times are polled.
+class ShaderWatcher {
+public:
+	explicit ShaderWatcher(const std::vector<std::string>& files);
+	~ShaderWatcher();
+
+	// files written since the last call, each one once
+	std::vector<std::string> takeChanged();
+
+private:
+	void watchEvents();
+	void pollTimes();
+	void markChanged(const std::string& file);
+
+	std::vector<std::string> mFiles;
+	std::vector<std::string> mChanged;
+	std::mutex mMutex;
+	std::atomic<bool> mStop;
+	std::thread mThread;
+	int mInotify = -1;
+};
+
+#endif
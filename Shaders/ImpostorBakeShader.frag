@@ -0,0 +1,27 @@
+#version 420
+
+in vec3 fObjectPos;
+in vec2 fTexCoord;
+
+uniform sampler2D objectTexture;
+uniform sampler2D normalTexture;
+uniform vec3 frameDirection;	// from the center to the camera of the frame
+uniform vec3 center;			// bounding sphere of the mesh
+uniform float radius;
+
+layout(location = 0) out vec4 color;
+layout(location = 1) out vec4 normalDepth;
+
+void main()
+{
+	// the same normal as the objects shader, reconstructed from the red and green of the normal map
+	vec2 normalXZ = texture(normalTexture, fTexCoord).rg * 2.0 - 1.0;
+	float normalBlue = sqrt(max(1.0 - dot(normalXZ, normalXZ), 0.0)) * 0.5 + 0.5;
+	vec3 normal = normalize(vec3(normalXZ.x, normalBlue, normalXZ.y));
+
+	// depth towards the camera of the frame, -1 to 1 over the bounding sphere
+	float depth = dot(fObjectPos - center, frameDirection) / radius;
+
+	color = vec4(texture(objectTexture, fTexCoord).rgb, 1.0);
+	normalDepth = vec4(normal * 0.5 + 0.5, depth * 0.5 + 0.5);
+}
@@ -0,0 +1,23 @@
+#version 420
+
+// renders a mesh into one frame of an impostor atlas, see Impostor::bake
+uniform mat4 frameViewProjection;
+uniform int numberOfRows;
+uniform int index;
+uniform vec3 meshOffset;	// AABB of the mesh to dequantize the positions
+uniform vec3 meshScale;
+
+layout(location = 0) in vec4 vPosQuantized;	// 16-bit normalized relative to the AABB
+layout(location = 3) in vec4 vTexCoord;		// half floats
+
+out vec3 fObjectPos;
+out vec2 fTexCoord;
+
+void main()
+{
+	vec3 position = meshOffset + vPosQuantized.xyz * meshScale;
+	vec2 atlasOffset = vec2(mod(float(index), float(numberOfRows)), floor(float(index) / float(numberOfRows))) / float(numberOfRows);
+	fTexCoord = vTexCoord.st / float(numberOfRows) + atlasOffset;
+	fObjectPos = position;
+	gl_Position = frameViewProjection * vec4(position, 1.0);
+}
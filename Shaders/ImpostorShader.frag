@@ -0,0 +1,71 @@
+#version 420
+
+in vec2 fAtlasCoord;
+in vec4 fClipPos;
+in vec4 fDepthClip;
+in vec3 fWorldPos;
+in vec3 fWorldCam;
+in vec3 fViewPos;
+in vec2 fTexCoordCaustic;
+
+uniform sampler2D colorAtlas;
+uniform sampler2D normalDepthAtlas;	// xyz: normal, w: depth towards the camera of the frame
+uniform sampler2DArray causticTextures;
+
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
+
+uniform float causticFrameCount;
+
+float causticFrame = mod(causticTime, causticFrameCount);	// the fraction blends to the next frame
+
+out vec4 fragmentColor;
+
+float Strength_Sun = 1.0f;
+vec4 fogColor = vec4(0.0f, 0.6f, 1.0f, 1.0f);
+
+// lit and fogged like the objects shader, with the texture and normal baked into the atlas
+void main()
+{
+	vec4 bakedColor = texture(colorAtlas, fAtlasCoord);
+	if (bakedColor.a < 0.5)
+		discard;
+	vec4 normalDepth = texture(normalDepthAtlas, fAtlasCoord);
+
+	// the fragment is moved from the quad onto the baked surface
+	vec4 clipPos = fClipPos + (normalDepth.w * 2.0 - 1.0) * fDepthClip;
+	gl_FragDepth = clipPos.z / clipPos.w * 0.5 + 0.5;
+
+	// caustic animation, blend between the current and the next frame
+	float layerCount = float(textureSize(causticTextures, 0).z);
+	float frame = floor(causticFrame);
+	vec4 causticCurrent = texture(causticTextures, vec3(fTexCoordCaustic, frame)).rgba;
+	vec4 causticNext = texture(causticTextures, vec3(fTexCoordCaustic, mod(frame + 1.0f, layerCount))).rgba;
+	vec4 causticColor = mix(causticCurrent, causticNext, causticFrame - frame);
+
+	vec3 L_Sun = normalize(worldSunDirection);
+	vec4 color = clamp(vec4(bakedColor.rgb, 1.0) + causticColor, 0.0, 1.0);
+	vec3 normal = normalize(normalDepth.xyz * 2.0 - 1.0);
+
+	// Fog
+	if(camPos.y < waterHeight){
+		float dist = length(fViewPos);
+		float fogFactor = exp(-pow(dist*0.01, 2.0));
+		fogFactor = clamp(fogFactor, 0.0, 1.0);
+		color = mix(fogColor, color, fogFactor);
+	}
+
+	fragmentColor = color * Strength_Sun * max(0.0, dot(normal, L_Sun));
+}
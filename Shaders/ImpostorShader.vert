@@ -0,0 +1,80 @@
+#version 420
+
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
+
+uniform samplerBuffer transforms;	// see TransformBatch
+const int TEXELS_PER_TRANSFORM = 8;
+uniform int frames;				// directions per side of the atlas, see Impostor
+uniform vec3 center;			// bounding sphere of the mesh in object space
+uniform float radius;
+uniform int terrainResolution;
+uniform int tileFactor;
+
+layout(location = 0) in vec4 vPosition;		// corner of the unit quad
+layout(location = 4) in vec4 vInstance;		// x: entry of the object in the selected range of the TransformBatch
+
+out vec2 fAtlasCoord;
+out vec4 fClipPos;
+out vec4 fDepthClip;		// clip space offset from the quad to the front of the bounding sphere
+out vec3 fWorldPos;
+out vec3 fWorldCam;
+out vec3 fViewPos;
+out vec2 fTexCoordCaustic;
+
+// the same mapping as Impostor::getFrameDirection
+vec3 frameDirection(ivec2 frame)
+{
+	vec2 uv = (vec2(frame) + 0.5) / float(frames) * 2.0 - 1.0;
+	vec3 direction = vec3(uv.x, 1.0 - abs(uv.x) - abs(uv.y), uv.y);
+	if (direction.y < 0.0)
+		direction.xz = (1.0 - abs(uv.yx)) * vec2(uv.x >= 0.0 ? 1.0 : -1.0, uv.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(direction);
+}
+
+void main()
+{
+	int texel = int(vInstance.x) * TEXELS_PER_TRANSFORM;
+	mat4 modelMatrix = mat4(texelFetch(transforms, texel), texelFetch(transforms, texel + 1), texelFetch(transforms, texel + 2), texelFetch(transforms, texel + 3));
+	mat4 modelViewProjection = mat4(texelFetch(transforms, texel + 4), texelFetch(transforms, texel + 5), texelFetch(transforms, texel + 6), texelFetch(transforms, texel + 7));
+
+	// the baked direction nearest to the camera, found by the octahedral encoding of the object space direction
+	vec3 eye = (inverse(modelMatrix) * vec4(inverseView[3].xyz, 1.0)).xyz;
+	vec3 toEye = normalize(eye - center);
+	toEye /= abs(toEye.x) + abs(toEye.y) + abs(toEye.z);
+	vec2 uv = toEye.xz;
+	if (toEye.y < 0.0)
+		uv = (1.0 - abs(toEye.zx)) * vec2(toEye.x >= 0.0 ? 1.0 : -1.0, toEye.z >= 0.0 ? 1.0 : -1.0);
+	ivec2 frame = clamp(ivec2((uv * 0.5 + 0.5) * float(frames)), ivec2(0), ivec2(frames - 1));
+	vec3 direction = frameDirection(frame);
+
+	// the quad lies in the image plane of the frame, with the axes of the lookAt used for baking it
+	vec3 up = abs(direction.y) > 0.99 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 side = normalize(cross(-direction, up));
+	vec3 screenUp = cross(side, -direction);
+	vec4 objectPos = vec4(center + (side * vPosition.x + screenUp * vPosition.y) * radius, 1.0);
+
+	vec4 worldPos = modelMatrix * objectPos;
+	gl_Position = modelViewProjection * objectPos;
+	gl_ClipDistance[0] = dot(worldPos, clipPlane);
+
+	fAtlasCoord = (vec2(frame) + vPosition.xy * 0.5 + 0.5) / float(frames);
+	fClipPos = gl_Position;
+	fDepthClip = modelViewProjection * vec4(direction * radius, 0.0);
+	fTexCoordCaustic = vec2(objectPos.x / float(terrainResolution - 1) * tileFactor, objectPos.z / float(terrainResolution - 1) * tileFactor);
+	fWorldPos = worldPos.xyz;
+	fWorldCam = inverseView[3].xyz;
+	fViewPos = (view * worldPos).xyz;
+}
@@ -8,27 +8,26 @@ in vec2 fTexCoordCaustic;
 
 uniform sampler2D objectTexture;
 uniform sampler2D normalTexture;
-uniform sampler2D causticTexture1;
-uniform sampler2D causticTexture2;
-uniform sampler2D causticTexture3;
-uniform sampler2D causticTexture4;
-uniform sampler2D causticTexture5;
-uniform sampler2D causticTexture6;
-uniform sampler2D causticTexture7;
-uniform sampler2D causticTexture8;
-uniform sampler2D causticTexture9;
-uniform sampler2D causticTexture10;
-uniform sampler2D causticTexture11;
-uniform sampler2D causticTexture12;
-uniform sampler2D causticTexture13;
-uniform sampler2D causticTexture14;
-uniform sampler2D causticTexture15;
-uniform sampler2D causticTexture16;
+uniform sampler2DArray causticTextures;
 
-uniform vec3 camPos;
-uniform float waterHeight;
-uniform int timeModulo;
-uniform vec3 worldSunDirection;
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
+
+uniform float causticFrameCount;
+
+float causticFrame = mod(causticTime, causticFrameCount);	// the fraction blends to the next frame
 
 out vec4 fragmentColor;
 
@@ -39,72 +38,12 @@ vec4 fogColor = vec4(0.0f, 0.6f, 1.0f, 1.0f);
 void main()
 {
 
-	vec4 caustic1 = texture(causticTexture1, fTexCoordCaustic).rgba;
-	vec4 caustic2 = texture(causticTexture2, fTexCoordCaustic).rgba;
-	vec4 caustic3 = texture(causticTexture3, fTexCoordCaustic).rgba;
-	vec4 caustic4 = texture(causticTexture4, fTexCoordCaustic).rgba;
-	vec4 caustic5 = texture(causticTexture5, fTexCoordCaustic).rgba;
-	vec4 caustic6 = texture(causticTexture6, fTexCoordCaustic).rgba;
-	vec4 caustic7 = texture(causticTexture7, fTexCoordCaustic).rgba;
-	vec4 caustic8 = texture(causticTexture8, fTexCoordCaustic).rgba;
-	vec4 caustic9 = texture(causticTexture9, fTexCoordCaustic).rgba;
-	vec4 caustic10 = texture(causticTexture10, fTexCoordCaustic).rgba;
-	vec4 caustic11 = texture(causticTexture11, fTexCoordCaustic).rgba;
-	vec4 caustic12 = texture(causticTexture12, fTexCoordCaustic).rgba;
-	vec4 caustic13 = texture(causticTexture13, fTexCoordCaustic).rgba;
-	vec4 caustic14 = texture(causticTexture14, fTexCoordCaustic).rgba;
-	vec4 caustic15 = texture(causticTexture15, fTexCoordCaustic).rgba;
-	vec4 caustic16 = texture(causticTexture16, fTexCoordCaustic).rgba;
-	vec4 causticColor = vec4(0.0f);
-
-	if(timeModulo == 0){
-		causticColor = caustic1;
-	}
-	else if (timeModulo == 1){
-		causticColor = caustic2;
-	}
-	else if (timeModulo == 2){
-		causticColor = caustic3;
-	}
-	else if (timeModulo == 3){
-		causticColor = caustic4;
-	}
-	else if (timeModulo == 4){
-		causticColor = caustic5;
-	}
-	else if (timeModulo == 5){
-		causticColor = caustic6;
-	}
-	else if (timeModulo == 6){
-		causticColor = caustic7;
-	}
-	else if (timeModulo == 7){
-		causticColor = caustic8;
-	}
-	else if (timeModulo == 8){
-		causticColor = caustic9;
-	}
-	else if (timeModulo == 9){
-		causticColor = caustic10;
-	}	
-	else if (timeModulo == 10){
-		causticColor = caustic11;
-	}
-	else if (timeModulo == 11){
-		causticColor = caustic12;
-	}
-	else if (timeModulo == 12){
-		causticColor = caustic13;
-	}
-	else if (timeModulo == 13){
-		causticColor = caustic14;
-	}
-	else if (timeModulo == 14){
-		causticColor = caustic15;
-	}
-	else if (timeModulo == 15){
-		causticColor = caustic16;
-	}
+	// caustic animation, blend between the current and the next frame
+	float layerCount = float(textureSize(causticTextures, 0).z);
+	float frame = floor(causticFrame);
+	vec4 causticCurrent = texture(causticTextures, vec3(fTexCoordCaustic, frame)).rgba;
+	vec4 causticNext = texture(causticTextures, vec3(fTexCoordCaustic, mod(frame + 1.0f, layerCount))).rgba;
+	vec4 causticColor = mix(causticCurrent, causticNext, causticFrame - frame);
 	
 	// sun light
 	vec3 V = normalize(fWorldCam - fWorldPos);
@@ -116,8 +55,10 @@ void main()
 	color = clamp(color, 0.0, 1.0);
 	
 	// normals
-	vec3 normalColors = texture(normalTexture, fTexCoord.st).rgb;
-	vec3 normal = vec3(normalColors.r * 2.0f - 1.0f, normalColors.b, normalColors.g * 2.0f - 1.0f);
+	// the normal map only stores red and green (BC5), blue is reconstructed in its original encoding
+	vec2 normalXZ = texture(normalTexture, fTexCoord.st).rg * 2.0f - 1.0f;
+	float normalBlue = sqrt(max(1.0f - dot(normalXZ, normalXZ), 0.0f)) * 0.5f + 0.5f;
+	vec3 normal = vec3(normalXZ.x, normalBlue, normalXZ.y);
 	normal = normalize(normal);
 
 	// Fog
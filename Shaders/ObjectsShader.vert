@@ -1,18 +1,43 @@
 #version 420
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
 
-uniform vec4 clipPlane;
+uniform samplerBuffer transforms;	// see TransformBatch
+uniform int transformIndex;
+const int TEXELS_PER_TRANSFORM = 8;
+uniform bool instanced;		// fish of a school or scattered plants, the transform comes from the instance attributes
+uniform bool swimming;		// the instances are fish
+uniform bool vertexAnimation;	// baked positions per frame, see VertexAnimation
+uniform sampler2D animationTexture;
+uniform int animationWidth;		// vertices per texture row
+uniform int animationRows;		// rows of the positions of one frame
+uniform int animationFrameCount;
+uniform float animationCycle;	// 0 to 1 over the animation, instances use their phase instead
 uniform int numberOfRows;
 uniform int index;
 uniform int terrainResolution;
 uniform int tileFactor;
+uniform vec3 meshOffset;	// AABB of the mesh to dequantize the positions
+uniform vec3 meshScale;
 
-layout(location = 0) in vec4 vPos;
-layout(location = 2) in vec4 vNormal;
-layout(location = 3) in vec4 vTexCoord;
+layout(location = 0) in vec4 vPosQuantized;	// 16-bit normalized relative to the AABB
+layout(location = 2) in vec2 vNormalOct;	// octahedral encoded normal
+layout(location = 3) in vec4 vTexCoord;		// half floats
+layout(location = 4) in vec4 vInstancePosition;	// xyz: position, w: scale
+layout(location = 5) in vec4 vInstanceVelocity;	// xyz: velocity, w: animation phase
 
 out vec3 fWorldPos;
 out vec4 fTexCoord;
@@ -31,18 +56,93 @@ vec2 calcIndexOffset()
 	return vec2(xOffset, yOffset);
 }
 
+// swimming of the school fish, a wave runs from the head at +z to the tail at -z
+// The phase of the tail beat is advanced with the speed of every fish by the flock simulation.
+const float PI = 3.14159265;
+const float FULL_SPEED = 8.0;			// the fish beat with full amplitude at this speed and above
+const float WAVE_NUMBER = 5.0;			// radians of the body wave per body length
+const float BEND_AMPLITUDE = 0.08;		// lateral bending at the tail in body lengths
+const float TAIL_AMPLITUDE = 0.06;		// additional flap of the tail fin in body lengths
+const float SWAY_ANGLE = 0.05;			// yaw of the whole body in radians
+const float SWAY_PIVOT = 0.7;			// the body turns around this point, 0 is the tail and 1 the head
+
+// lateral offset in body lengths, along is 0 at the tail and 1 at the head
+float swimOffset(float along, float phase, float strength)
+{
+	float back = 1.0 - along;
+	float bend = BEND_AMPLITUDE * back * back * sin(phase - WAVE_NUMBER * back);
+	float flap = TAIL_AMPLITUDE * smoothstep(0.75, 1.0, back) * sin(phase - WAVE_NUMBER);
+	float sway = SWAY_ANGLE * (along - SWAY_PIVOT) * sin(phase + 0.5 * PI);
+	return strength * (bend + flap + sway);
+}
+
+// bends the object space position sideways
+void swim(inout vec3 position)
+{
+	float bodyLength = meshScale.z;
+	float along = (position.z - meshOffset.z) / bodyLength;
+	float phase = vInstanceVelocity.w;
+	float strength = mix(0.5, 1.0, clamp(length(vInstanceVelocity.xyz) / FULL_SPEED, 0.0, 1.0));	// slow fish beat gently
+
+	position.x += swimOffset(along, phase, strength) * bodyLength;
+}
+
+// position of the vertex blended between the two nearest baked frames
+void playAnimation(inout vec3 position)
+{
+	float cycle = instanced ? vInstanceVelocity.w / (2.0 * PI) : animationCycle;
+	float frame = fract(cycle) * float(animationFrameCount);
+	int frame0 = int(frame) % animationFrameCount;
+	int frame1 = (frame0 + 1) % animationFrameCount;
+	float blend = fract(frame);
+
+	ivec2 texel = ivec2(gl_VertexID % animationWidth, gl_VertexID / animationWidth);
+	ivec2 row0 = ivec2(0, frame0 * animationRows);
+	ivec2 row1 = ivec2(0, frame1 * animationRows);
+	position = mix(texelFetch(animationTexture, texel + row0, 0).xyz, texelFetch(animationTexture, texel + row1, 0).xyz, blend);
+}
+
+// the model looks along +z, it is turned into the direction (swimming or facing) and stays upright
+mat4 instanceMatrix()
+{
+	vec3 forward = normalize(vInstanceVelocity.xyz);
+	vec3 side = cross(vec3(0.0, 1.0, 0.0), forward);
+	side = length(side) > 0.001 ? normalize(side) : vec3(1.0, 0.0, 0.0);
+	vec3 up = cross(forward, side);
+	float scale = vInstancePosition.w;
+	return mat4(vec4(side * scale, 0.0), vec4(up * scale, 0.0), vec4(forward * scale, 0.0), vec4(vInstancePosition.xyz, 1.0));
+}
+
 void main()
 {
+	vec4 vPos = vec4(meshOffset + vPosQuantized.xyz * meshScale, 1.0);
+	if (vertexAnimation)
+		playAnimation(vPos.xyz);
+	else if (instanced && swimming)
+		swim(vPos.xyz);
 
-	vec4 worldPos = model * vPos;
+	vec4 worldPos;
+	if (instanced)
+	{
+		mat4 modelMatrix = instanceMatrix();
+		worldPos = modelMatrix * vPos;
+		gl_Position = projection * (view * worldPos);
+	}
+	else
+	{
+		// matrices of the draw, computed for the whole pass by the TransformBatch
+		int texel = transformIndex * TEXELS_PER_TRANSFORM;
+		mat4 modelMatrix = mat4(texelFetch(transforms, texel), texelFetch(transforms, texel + 1), texelFetch(transforms, texel + 2), texelFetch(transforms, texel + 3));
+		mat4 modelViewProjection = mat4(texelFetch(transforms, texel + 4), texelFetch(transforms, texel + 5), texelFetch(transforms, texel + 6), texelFetch(transforms, texel + 7));
+		worldPos = modelMatrix * vPos;
+		gl_Position = modelViewProjection * vPos;
+	}
 	gl_ClipDistance[0] = dot(worldPos, clipPlane);
-	
-    gl_Position = (projection * view * model) * vPos;       	
-	
+
 	fTexCoord = vTexCoord / numberOfRows + vec4(calcIndexOffset(), 0.0f, 0.0f); 
 	fTexCoordCaustic = vec2(vPos.x / float(terrainResolution - 1) * tileFactor, vPos.z / float(terrainResolution - 1) * tileFactor);
-	fWorldPos = (model * vPos).xyz;
-	fWorldCam = (inverse(view) * vec4(0.0, 0.0, 0.0, 1.0)).xyz;
-	fViewPos = (view * model * vPos).xyz;                  
+	fWorldPos = worldPos.xyz;
+	fWorldCam = inverseView[3].xyz;
+	fViewPos = (view * worldPos).xyz;
 
 }
\ No newline at end of file
@@ -9,27 +9,26 @@ in vec3 fWorldNormal;
 
 uniform sampler2D seafloorTexture;
 uniform sampler2D seafloorNormalTexture;
-uniform sampler2D causticTexture1;
-uniform sampler2D causticTexture2;
-uniform sampler2D causticTexture3;
-uniform sampler2D causticTexture4;
-uniform sampler2D causticTexture5;
-uniform sampler2D causticTexture6;
-uniform sampler2D causticTexture7;
-uniform sampler2D causticTexture8;
-uniform sampler2D causticTexture9;
-uniform sampler2D causticTexture10;
-uniform sampler2D causticTexture11;
-uniform sampler2D causticTexture12;
-uniform sampler2D causticTexture13;
-uniform sampler2D causticTexture14;
-uniform sampler2D causticTexture15;
-uniform sampler2D causticTexture16;
+uniform sampler2DArray causticTextures;
 
-uniform vec3 camPos;
-uniform vec3 worldSunDirection;
-uniform float waterHeight;
-uniform int timeModulo;
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
+
+uniform float causticFrameCount;
+
+float causticFrame = mod(causticTime, causticFrameCount);	// the fraction blends to the next frame
 
 out vec4 fragmentColor;
 
@@ -43,72 +42,12 @@ vec4 water = vec4(0.1f, 1.0f, 0.9f, 1.0f);
 void main()
 {
 
-	vec4 caustic1 = texture(causticTexture1, fTexCoord.st).rgba;
-	vec4 caustic2 = texture(causticTexture2, fTexCoord.st).rgba;
-	vec4 caustic3 = texture(causticTexture3, fTexCoord.st).rgba;
-	vec4 caustic4 = texture(causticTexture4, fTexCoord.st).rgba;
-	vec4 caustic5 = texture(causticTexture5, fTexCoord.st).rgba;
-	vec4 caustic6 = texture(causticTexture6, fTexCoord.st).rgba;
-	vec4 caustic7 = texture(causticTexture7, fTexCoord.st).rgba;
-	vec4 caustic8 = texture(causticTexture8, fTexCoord.st).rgba;
-	vec4 caustic9 = texture(causticTexture9, fTexCoord.st).rgba;
-	vec4 caustic10 = texture(causticTexture10, fTexCoord.st).rgba;
-	vec4 caustic11 = texture(causticTexture11, fTexCoord.st).rgba;
-	vec4 caustic12 = texture(causticTexture12, fTexCoord.st).rgba;
-	vec4 caustic13 = texture(causticTexture13, fTexCoord.st).rgba;
-	vec4 caustic14 = texture(causticTexture14, fTexCoord.st).rgba;
-	vec4 caustic15 = texture(causticTexture15, fTexCoord.st).rgba;
-	vec4 caustic16 = texture(causticTexture16, fTexCoord.st).rgba;
-	vec4 causticColor = vec4(0.0f);
-	
-	if(timeModulo == 0){
-		causticColor = caustic1;
-	}
-	else if (timeModulo == 1){
-		causticColor = caustic2;
-	}
-	else if (timeModulo == 2){
-		causticColor = caustic3;
-	}
-	else if (timeModulo == 3){
-		causticColor = caustic4;
-	}
-	else if (timeModulo == 4){
-		causticColor = caustic5;
-	}
-	else if (timeModulo == 5){
-		causticColor = caustic6;
-	}
-	else if (timeModulo == 6){
-		causticColor = caustic7;
-	}
-	else if (timeModulo == 7){
-		causticColor = caustic8;
-	}
-	else if (timeModulo == 8){
-		causticColor = caustic9;
-	}
-	else if (timeModulo == 9){
-		causticColor = caustic10;
-	}	
-	else if (timeModulo == 10){
-		causticColor = caustic11;
-	}
-	else if (timeModulo == 11){
-		causticColor = caustic12;
-	}
-	else if (timeModulo == 12){
-		causticColor = caustic13;
-	}
-	else if (timeModulo == 13){
-		causticColor = caustic14;
-	}
-	else if (timeModulo == 14){
-		causticColor = caustic15;
-	}
-	else if (timeModulo == 15){
-		causticColor = caustic16;
-	}
+	// caustic animation, blend between the current and the next frame
+	float layerCount = float(textureSize(causticTextures, 0).z);
+	float frame = floor(causticFrame);
+	vec4 causticCurrent = texture(causticTextures, vec3(fTexCoord.st, frame)).rgba;
+	vec4 causticNext = texture(causticTextures, vec3(fTexCoord.st, mod(frame + 1.0f, layerCount))).rgba;
+	vec4 causticColor = mix(causticCurrent, causticNext, causticFrame - frame);
 	
 	//texture
 	vec4 seafloor = texture(seafloorTexture, fTexCoord.st).rgba;
@@ -116,8 +55,10 @@ void main()
 	color = clamp(color, 0.0f, 1.0f);
 	
 	// normals
-	vec3 normalColors = texture(seafloorNormalTexture, fTexCoord.st).rgb;
-	vec3 normalFromTexture = vec3(normalColors.r * 2.0f - 1.0f, normalColors.b, normalColors.g * 2.0f - 1.0f);
+	// the normal map only stores red and green (BC5), blue is reconstructed in its original encoding
+	vec2 normalXZ = texture(seafloorNormalTexture, fTexCoord.st).rg * 2.0f - 1.0f;
+	float normalBlue = sqrt(max(1.0f - dot(normalXZ, normalXZ), 0.0f)) * 0.5f + 0.5f;
+	vec3 normalFromTexture = vec3(normalXZ.x, normalBlue, normalXZ.y);
 	vec3 normal = fWorldNormal + fModelInvT*normalFromTexture;
 	normal = normalize(normal);
 	
@@ -18,8 +18,20 @@ uniform sampler2D waterDudv1;
 uniform sampler2D waterDudv2;
 uniform sampler2D reflectionTexture;
 uniform sampler2D refractionTexture;
-uniform vec3 worldSunDirection;
-uniform float time;
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
 uniform int terrainResolution;
 uniform int tileFactor;
 
@@ -1,14 +1,23 @@
 #version 420
 
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
+
 uniform mat4 model;
 uniform mat3 modelInvT;
-uniform mat4 view;
-uniform mat4 projection;
-
-uniform vec4 clipPlane;
-uniform vec3 worldSunDirection;
 
-uniform float time;
 uniform float amplitude;
 uniform float frequency;
 
@@ -85,7 +94,7 @@ void main()
 
 	fWorldPos = (model * position).xyz;
 	fWorldNormal = normalize(modelInvT * normal.xyz);		
-	fWorldCam = (inverse(view) * vec4(0.0, 0.0, 0.0, 1.0)).xyz;
+	fWorldCam = inverseView[3].xyz;
 
 	fViewPos = (view * model * position).xyz;
 
@@ -1,7 +1,19 @@
 #version 420
 
-uniform mat4 view;
-uniform mat4 projection;
+// constants of the frame and of the render pass, shared by all programs (SceneUniforms)
+layout(std140, binding = 0) uniform PerFrame {
+	vec3 worldSunDirection;
+	float waterHeight;
+	float time;					// seconds since start
+	float causticTime;			// caustic animation time in frames, wrapped with causticFrameCount
+};
+layout(std140, binding = 1) uniform PerPass {
+	mat4 view;
+	mat4 projection;
+	mat4 inverseView;			// camera to world, the mirrored camera in the reflection pass
+	vec4 clipPlane;
+	vec3 camPos;				// the camera above or below the water, not mirrored
+};
 
 layout(location = 0) in vec4 vPos;
 
@@ -9,6 +21,6 @@ out vec4 fTexCoord;
 void main()
 {
 	fTexCoord = vPos;
-	gl_Position = (projection * view) * vPos;
+	gl_Position = (projection * mat4(mat3(view))) * vPos;	// without translation, the skybox moves with the camera
 
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "SimpleShaders.h"
+#include "GLState.h"
+#include "AssetPack.h"
+#include "ShaderCache.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -15,68 +19,336 @@ SimpleShaders::~SimpleShaders()
 }
 
 // load vertex and fragment shaders, create and activate shader program, check for errors
+// A binary of the same sources linked by the same driver is taken from the ShaderCache instead.
 bool SimpleShaders::loadVertexFragmentShaders(const char* vertexShaderFilename, const char* fragmentShaderFilename)
 {
-	// Create empty shader object (vertex shader)
-	mVertexShader = glCreateShader(GL_VERTEX_SHADER);
+	string vertexSource = readFile( vertexShaderFilename );
+	string fragmentSource = readFile( fragmentShaderFilename );
+	uint64_t cacheKey = ShaderCache::makeKey(vertexSource, fragmentSource);
+	mShaderProgram = ShaderCache::load(cacheKey);
+	bool cached = mShaderProgram != 0;
+	bool linked = cached;
+	mVertexShader = 0;
+	mFragmentShader = 0;
 
-	// Read vertex shader source 
-	string shaderSource = readFile( vertexShaderFilename );
-	const char* sourcePtr = shaderSource.c_str();
+	if (!cached) {
+		// Create empty shader object (vertex shader)
+		mVertexShader = glCreateShader(GL_VERTEX_SHADER);
 
-	// Attach shader code
-	glShaderSource(mVertexShader, 1, &sourcePtr, NULL);	
+		// Attach shader code
+		const char* sourcePtr = vertexSource.c_str();
+		glShaderSource(mVertexShader, 1, &sourcePtr, NULL);
 
-	// Compile
-	glCompileShader(mVertexShader);
-	printShaderInfoLog(mVertexShader);
+		// Compile
+		glCompileShader(mVertexShader);
+		printShaderInfoLog(mVertexShader);
 
-	// Create empty shader object (fragment shader)
-	mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+		// Create empty shader object (fragment shader)
+		mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-	// Read vertex shader source 
-	shaderSource = readFile( fragmentShaderFilename );
-	sourcePtr = shaderSource.c_str();
+		// Attach shader code
+		sourcePtr = fragmentSource.c_str();
+		glShaderSource(mFragmentShader, 1, &sourcePtr, NULL);
 
-	// Attach shader code
-	glShaderSource(mFragmentShader, 1, &sourcePtr, NULL);	
+		// Compile
+		glCompileShader(mFragmentShader);
+		printShaderInfoLog(mFragmentShader);
 
-	// Compile
-	glCompileShader(mFragmentShader);
-	printShaderInfoLog(mFragmentShader);
+		// Create shader program
+		mShaderProgram = glCreateProgram();
 
-	// Create shader program
-	mShaderProgram = glCreateProgram();	
+		// Attach shader
+		glAttachShader(mShaderProgram, mVertexShader);
+		glAttachShader(mShaderProgram, mFragmentShader);
 
-	// Attach shader
-	glAttachShader(mShaderProgram, mVertexShader);
-	glAttachShader(mShaderProgram, mFragmentShader);
+		// Link program
+		ShaderCache::prepare(mShaderProgram);
+		glLinkProgram(mShaderProgram);
+		printProgramInfoLog(mShaderProgram);
 
-	// Link program
-	glLinkProgram(mShaderProgram);
-	printProgramInfoLog();
+		GLint status = GL_FALSE;
+		glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &status);
+		linked = status == GL_TRUE;
+		if (linked)
+			ShaderCache::store(cacheKey, mShaderProgram);
+	}
+
+	mVertexShaderFilename = vertexShaderFilename;
+	mFragmentShaderFilename = fragmentShaderFilename;
+	reflectUniforms();
+	GLState::useProgram(mShaderProgram);
+	initUniforms();
+
+	printf(cached ? "Vertex/Fragment Shaders loaded from the cache\n" : "Vertex/Fragment Shaders loaded\n");
+	return linked;
+}
+
+// the asset pack is skipped so that the edited files are used
+void SimpleShaders::beginReload()
+{
+	discardReload();
+	string vertexSource = readFile(mVertexShaderFilename, false);
+	string fragmentSource = readFile(mFragmentShaderFilename, false);
+	if (vertexSource.empty() || fragmentSource.empty())
+		return;
+
+	// an edit that was undone is still in the cache
+	mPendingKey = ShaderCache::makeKey(vertexSource, fragmentSource);
+	mPendingProgram = ShaderCache::load(mPendingKey);
+	if (mPendingProgram != 0)
+		return;
+
+	// nothing here waits for the compiler, the status is only asked for in updateReload
+	const char* sourcePtr = vertexSource.c_str();
+	mPendingVertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(mPendingVertexShader, 1, &sourcePtr, NULL);
+	glCompileShader(mPendingVertexShader);
+	sourcePtr = fragmentSource.c_str();
+	mPendingFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(mPendingFragmentShader, 1, &sourcePtr, NULL);
+	glCompileShader(mPendingFragmentShader);
+
+	mPendingProgram = glCreateProgram();
+	glAttachShader(mPendingProgram, mPendingVertexShader);
+	glAttachShader(mPendingProgram, mPendingFragmentShader);
+	ShaderCache::prepare(mPendingProgram);
+	glLinkProgram(mPendingProgram);
+}
+
+// with KHR_parallel_shader_compile the driver compiles on its own threads and the program is asked for again next
+// frame, otherwise the first query waits for the compiler
+bool SimpleShaders::updateReload()
+{
+	if (mPendingProgram == 0)
+		return false;
+	if (GLEW_KHR_parallel_shader_compile) {
+		GLint completed = GL_FALSE;
+		glGetProgramiv(mPendingProgram, GL_COMPLETION_STATUS_KHR, &completed);
+		if (completed != GL_TRUE)
+			return false;
+	}
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(mPendingProgram, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		printf("[SimpleShaders] Reloading %s failed, the previous program stays in use\n", mVertexShaderFilename.c_str());
+		if (mPendingVertexShader != 0) {
+			printShaderInfoLog(mPendingVertexShader);
+			printShaderInfoLog(mPendingFragmentShader);
+		}
+		printProgramInfoLog(mPendingProgram);
+		discardReload();
+		return false;
+	}
+	if (mPendingVertexShader != 0)
+		ShaderCache::store(mPendingKey, mPendingProgram);
 
+	// the old program is unbound first, its name may be handed out again and GLState would skip binding it
+	GLState::useProgram(0);
+	glDeleteProgram(mShaderProgram);
+	if (mVertexShader != 0) {		// none for a program from the ShaderCache
+		glDeleteShader(mVertexShader);
+		glDeleteShader(mFragmentShader);
+	}
+	mShaderProgram = mPendingProgram;
+	mVertexShader = mPendingVertexShader;
+	mFragmentShader = mPendingFragmentShader;
+	mPendingProgram = 0;
+	mPendingVertexShader = 0;
+	mPendingFragmentShader = 0;
 
-	printf("Vertex/Fragment Shaders loaded\n");
+	reflectUniforms();
+	GLState::useProgram(mShaderProgram);
+	initUniforms();
+	printf("%s and %s reloaded\n", mVertexShaderFilename.c_str(), mFragmentShaderFilename.c_str());
 	return true;
 }
 
+void SimpleShaders::discardReload()
+{
+	if (mPendingProgram == 0)
+		return;
+	glDeleteProgram(mPendingProgram);
+	if (mPendingVertexShader != 0) {
+		glDeleteShader(mPendingVertexShader);
+		glDeleteShader(mPendingFragmentShader);
+	}
+	mPendingProgram = 0;
+	mPendingVertexShader = 0;
+	mPendingFragmentShader = 0;
+}
+
 void SimpleShaders::activate()
 {
-	glUseProgram(mShaderProgram);
+	GLState::useProgram(mShaderProgram);
 }
 
 void SimpleShaders::deactivate()
 {
-	glUseProgram(0);
+	GLState::useProgram(0);
+}
+
+// collect the locations of all active uniforms and the sizes of the uniform blocks, members of blocks have no location
+void SimpleShaders::reflectUniforms()
+{
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	size_t capacity = 16;
+	while (capacity < static_cast<size_t>(uniformCount) * 2)
+		capacity *= 2;
+	mUniforms.assign(capacity, UniformSlot{ 0, -1, false });
+	mUniformCount = 0;
+
+	std::vector<char> name(std::max(maxNameLength, 1));
+	for (GLint i = 0; i < uniformCount; i++) {
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(mShaderProgram, i, static_cast<GLsizei>(name.size()), NULL, &size, &type, name.data());
+		GLint location = glGetUniformLocation(mShaderProgram, name.data());
+		if (location < 0)
+			continue;
+		string uniformName = name.data();
+		size_t bracket = uniformName.find('[');			// arrays are reported as name[0]
+		if (bracket != string::npos)
+			uniformName.resize(bracket);
+		if (!insertUniform(UniformName::hashName(uniformName.c_str()), location))
+			printf("[SimpleShaders] Uniform %s has the hash of another active uniform in %s, setting one changes the other\n",
+				uniformName.c_str(), mVertexShaderFilename.c_str());
+	}
+
+	GLint blockCount = 0;
+	GLint maxBlockNameLength = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+	name.resize(std::max(maxBlockNameLength, 1));
+	mBlocks.clear();
+	for (GLint i = 0; i < blockCount; i++) {
+		UniformBlock block;
+		glGetActiveUniformBlockName(mShaderProgram, i, static_cast<GLsizei>(name.size()), NULL, name.data());
+		glGetActiveUniformBlockiv(mShaderProgram, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.size);
+		block.hash = UniformName::hashName(name.data());
+		mBlocks.push_back(block);
+	}
+}
+
+// false if the hash is already in the table, the location is replaced then
+bool SimpleShaders::insertUniform(uint32_t hash, GLint location)
+{
+	// at most three quarters full, otherwise the probes get long
+	if ((mUniformCount + 1) * 4 > mUniforms.size() * 3) {
+		std::vector<UniformSlot> previous(std::max(mUniforms.size() * 2, static_cast<size_t>(16)), UniformSlot{ 0, -1, false });
+		previous.swap(mUniforms);
+		mUniformCount = 0;
+		for (const UniformSlot& uniform : previous)
+			if (uniform.used)
+				insertUniform(uniform.hash, uniform.location);
+	}
+
+	size_t mask = mUniforms.size() - 1;
+	size_t slot = hash & mask;
+	while (mUniforms[slot].used && mUniforms[slot].hash != hash)
+		slot = (slot + 1) & mask;
+	bool inserted = !mUniforms[slot].used;
+	mUniforms[slot].hash = hash;
+	mUniforms[slot].location = location;
+	mUniforms[slot].used = true;
+	if (inserted)
+		mUniformCount++;
+	return inserted;
+}
+
+GLint SimpleShaders::findUniform(const UniformName& name)
+{
+	if (mUniforms.empty())
+		return -1;
+	size_t mask = mUniforms.size() - 1;
+	for (size_t slot = name.hash & mask; mUniforms[slot].used; slot = (slot + 1) & mask)
+		if (mUniforms[slot].hash == name.hash)
+			return mUniforms[slot].location;
+
+	// remembered as missing so that the warning appears once
+	printf("[SimpleShaders] Uniform %s not found in %s\n", name.name, mVertexShaderFilename.c_str());
+	insertUniform(name.hash, -1);
+	return -1;
+}
+
+void SimpleShaders::setUniform(const UniformName& name, int value)
+{
+	GLint location = findUniform(name);
+	if (location < 0)
+		return;
+	GLState::useProgram(mShaderProgram);
+	glUniform1i(location, value);
+}
+
+void SimpleShaders::setUniform(const UniformName& name, float value)
+{
+	GLint location = findUniform(name);
+	if (location < 0)
+		return;
+	GLState::useProgram(mShaderProgram);
+	glUniform1f(location, value);
+}
+
+void SimpleShaders::setUniform(const UniformName& name, const glm::vec3& value)
+{
+	GLint location = findUniform(name);
+	if (location < 0)
+		return;
+	GLState::useProgram(mShaderProgram);
+	glUniform3fv(location, 1, &value[0]);
+}
+
+void SimpleShaders::setUniform(const UniformName& name, const glm::vec4& value)
+{
+	GLint location = findUniform(name);
+	if (location < 0)
+		return;
+	GLState::useProgram(mShaderProgram);
+	glUniform4fv(location, 1, &value[0]);
+}
+
+void SimpleShaders::setUniform(const UniformName& name, const glm::mat3& value)
+{
+	GLint location = findUniform(name);
+	if (location < 0)
+		return;
+	GLState::useProgram(mShaderProgram);
+	glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void SimpleShaders::setUniform(const UniformName& name, const glm::mat4& value)
+{
+	GLint location = findUniform(name);
+	if (location < 0)
+		return;
+	GLState::useProgram(mShaderProgram);
+	glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+GLint SimpleShaders::getBlockSize(const UniformName& name) const
+{
+	for (const UniformBlock& block : mBlocks)
+		if (block.hash == name.hash)
+			return block.size;
+	return -1;
 }
 
 // Reads a file and returns the content as a string
-string SimpleShaders::readFile(string fileName)
+string SimpleShaders::readFile(string fileName, bool packed)
 {
 	string fileContent;
 	string line;
 
+	// shaders shipped in the asset pack are read from the mapping
+	const char* packedData;
+	size_t packedSize;
+	if (packed && AssetPack::find(fileName, packedData, packedSize))
+		return string(packedData, packedSize);
+
 	ifstream file(fileName.c_str());
 	if (file.is_open()) {
 		while (!file.eof()){
@@ -110,17 +382,17 @@ void SimpleShaders::printShaderInfoLog(GLuint shader)
 }
 
 // Print information about the linking step
-void SimpleShaders::printProgramInfoLog()
+void SimpleShaders::printProgramInfoLog(GLuint program)
 {
 	GLint infoLogLength = 0;
 	GLsizei charsWritten  = 0;
 	char *infoLog;
 
-	glGetProgramiv(mShaderProgram, GL_INFO_LOG_LENGTH,&infoLogLength);
+	glGetProgramiv(program, GL_INFO_LOG_LENGTH,&infoLogLength);
 	if (infoLogLength > 0)
 	{
 		infoLog = (char *)malloc(infoLogLength);
-		glGetProgramInfoLog(mShaderProgram, infoLogLength, &charsWritten, infoLog);
+		glGetProgramInfoLog(program, infoLogLength, &charsWritten, infoLog);
 		printf("%s\n", infoLog);
 		free(infoLog);
 	}
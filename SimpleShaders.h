@@ -4,7 +4,23 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include <glm/glm.hpp>
 #include <string>
+#include <vector>
+#include <stdint.h>
+
+// name of a uniform or uniform block with its FNV-1a hash, computed at compile time for constexpr instances
+struct UniformName {
+	const char* name;
+	uint32_t hash;
+
+	constexpr UniformName(const char* uniformName) : name(uniformName), hash(hashName(uniformName)) {}
+
+	static constexpr uint32_t hashName(const char* s, uint32_t h = 2166136261u)
+	{
+		return *s ? hashName(s + 1, (h ^ static_cast<uint8_t>(*s)) * 16777619u) : h;
+	}
+};
 
 class SimpleShaders
 {
@@ -12,20 +28,73 @@ public:
 	explicit SimpleShaders();
 	virtual ~SimpleShaders();
 
+	// compiles and links, then reads the active uniforms and blocks of the program and calls initUniforms
 	bool loadVertexFragmentShaders(const char* vertexShaderFilename, const char* fragmentShaderFilename);
 
+	// compiles the loose files again without waiting for the driver, the current program stays in use
+	void beginReload();
+	// once per frame on the GL thread: swaps in the reloaded program if it linked, true when it did
+	bool updateReload();
+	bool usesFile(const std::string& fileName) const { return fileName == mVertexShaderFilename || fileName == mFragmentShaderFilename; }
+	const std::string& getVertexShaderFile() const { return mVertexShaderFilename; }
+	const std::string& getFragmentShaderFile() const { return mFragmentShaderFilename; }
+
 	virtual void activate();
 	virtual void deactivate();
 
+	GLuint getProgram() const { return mShaderProgram; }
+	virtual GLuint getMainTexture() const { return 0; }	// used to group draws by texture
+
+	// typed setters, a uniform the program does not use is reported once and ignored afterwards
+	void setUniform(const UniformName& name, int value);
+	void setUniform(const UniformName& name, float value);
+	void setUniform(const UniformName& name, const glm::vec3& value);
+	void setUniform(const UniformName& name, const glm::vec4& value);
+	void setUniform(const UniformName& name, const glm::mat3& value);
+	void setUniform(const UniformName& name, const glm::mat4& value);
+
+	GLint getBlockSize(const UniformName& name) const;		// -1 if the program has no such block
+
 protected:
-	std::string readFile(std::string fileName);
+	// values that stay constant for the program, e.g. sampler units
+	virtual void initUniforms() {}
+
+	std::string readFile(std::string fileName, bool packed = true);	// packed: from the asset pack if it holds the file
 
 	void printShaderInfoLog(GLuint shader);
-	void printProgramInfoLog();
+	void printProgramInfoLog(GLuint program);
+
+	GLuint mVertexShader = 0;		// 0 for a binary from the ShaderCache
+	GLuint mFragmentShader = 0;
+	GLuint mShaderProgram = 0;
+
+private:
+	struct UniformSlot {
+		uint32_t hash;
+		GLint location;					// -1 for names that were asked for but are not active
+		bool used;
+	};
+	struct UniformBlock {
+		uint32_t hash;
+		GLint size;
+	};
+
+	void discardReload();
+	void reflectUniforms();
+	bool insertUniform(uint32_t hash, GLint location);
+	GLint findUniform(const UniformName& name);
+
+	std::string mVertexShaderFilename;
+	std::string mFragmentShaderFilename;
 
-	GLuint mVertexShader;	
-	GLuint mFragmentShader;
-	GLuint mShaderProgram;
+	// program being compiled by beginReload
+	GLuint mPendingProgram = 0;
+	GLuint mPendingVertexShader = 0;		// 0 for a binary from the ShaderCache
+	GLuint mPendingFragmentShader = 0;
+	uint64_t mPendingKey = 0;
+	std::vector<UniformSlot> mUniforms;			// open addressing, power of two size
+	size_t mUniformCount = 0;					// used slots, active and missing uniforms
+	std::vector<UniformBlock> mBlocks;
 };
 
 #endif
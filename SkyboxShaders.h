@@ -9,29 +9,21 @@ class SkyboxShaders : public SimpleShaders
 {
 public:
 	
-	SkyboxShaders(int textureResolution, std::vector<std::string> texture_path, float waterHeight);
+	SkyboxShaders(int textureResolution, std::vector<std::string> texture_path);
 	~SkyboxShaders();
-	void locateUniforms();
 	void activate() override;
+	GLuint getMainTexture() const override { return static_cast<GLuint>(mTextureID); }
 
-	void setViewMatrix(const glm::mat4& viewMatrix);
-	void setProjectionMatrix(const glm::mat4& projMatrix);
-	void setCameraPos(const glm::vec3& cameraPos);
-
+protected:
+	void initUniforms() override;
 
 private:
 
 	GLuint generateSkyBox(int resolution, std::vector<std::string> texture_path);
 
-	GLint mViewLocation = -1;
-	GLint mProjectionLocation = -1;
-	GLint mCubeSamplerLocation = -1;
-	GLint mCameraPosLocation = -1;
-	GLint mWaterHeightLocation = -1;
 	GLint mTextureID;
 
 	std::vector<std::string> mTexturePath;
-	const float mWaterHeight;
 };
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <stdlib.h>
+#include <algorithm>
 #include <GL/freeglut.h>
 
 #ifndef TYPE_WATER
@@ -160,6 +161,49 @@ float Terrain::getHeightValue(float x, float z) const
 
 }
 
+// coarse grid with a vertex every step height values, used as occluder for the occlusion culling. Every vertex takes
+// the lowest height around it, so the grid stays below the surface and does not hide anything visible from above.
+void Terrain::getOccluderMesh(int step, std::vector<vec3>& positions, std::vector<uint32_t>& indices) const
+{
+	positions.clear();
+	indices.clear();
+	int count = (mResolution - 3) / step + 1;		// same extent as the drawn vertices, 1 to mResolution - 2
+
+	for (int gz = 0; gz < count; gz++) {
+		for (int gx = 0; gx < count; gx++) {
+			int x = 1 + gx * step;
+			int z = 1 + gz * step;
+			float lowest = getHeight(x, z);
+			for (int sz = std::max(1, z - step); sz <= std::min(mResolution - 2, z + step); sz++)
+				for (int sx = std::max(1, x - step); sx <= std::min(mResolution - 2, x + step); sx++)
+					lowest = std::min(lowest, getHeight(sx, sz));
+			positions.push_back(vec3(static_cast<float>(x), lowest, static_cast<float>(z)));
+		}
+	}
+
+	for (int gz = 0; gz < count - 1; gz++) {
+		for (int gx = 0; gx < count - 1; gx++) {
+			uint32_t corner = gz * count + gx;
+			indices.insert(indices.end(), { corner, corner + 1, corner + count + 1, corner, corner + count + 1, corner + count });
+		}
+	}
+}
+
+// axis aligned box around the drawn vertices in object space
+void Terrain::getBounds(vec3& boundsMin, vec3& boundsMax) const
+{
+	float lowest = getHeight(1, 1);
+	float highest = lowest;
+	for (int z = 1; z < mResolution - 1; z++) {
+		for (int x = 1; x < mResolution - 1; x++) {
+			lowest = std::min(lowest, getHeight(x, z));
+			highest = std::max(highest, getHeight(x, z));
+		}
+	}
+	boundsMin = vec3(1.0f, lowest, 1.0f);
+	boundsMax = vec3(static_cast<float>(mResolution - 2), highest, static_cast<float>(mResolution - 2));
+}
+
 int Terrain::calcIndex(int x, int z)
 {
 	return z * (mResolution - 2) + x;
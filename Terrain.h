@@ -4,6 +4,7 @@
 #include "VertexArrayObject.h"
 #include <glm/glm.hpp>
 #include <vector>
+#include <stdint.h>
 
 using namespace glm;
 
@@ -19,6 +20,8 @@ public:
 	int calcIndex(int x, int z);
 
 	void setVAOPositions(bool generateHeight);
+	void getOccluderMesh(int step, std::vector<vec3>& positions, std::vector<uint32_t>& indices) const;
+	void getBounds(vec3& boundsMin, vec3& boundsMax) const;
 
 private:     
 	void drawSimplePlane();
@@ -0,0 +1,244 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "TextureCompressor.h"
+
+extern "C" {
+#include "External Libraries\SOIL\include\image_DXT.h"
+}
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+static const unsigned int DDS_MAGIC = 0x20534444;			// "DDS "
+static const unsigned int FOURCC_DXT1 = 0x31545844;		// "DXT1"
+static const unsigned int FOURCC_DXT5 = 0x35545844;		// "DXT5"
+static const unsigned int FOURCC_ATI2 = 0x32495441;		// "ATI2", the legacy four character code of BC5
+static const unsigned int CACHE_VERSION = 2;				// stored in the reserved part of the header
+
+bool TextureCompressor::compress(const unsigned char* pixels, int width, int height, int channels, CompressedImage::Format format, CompressedImage& image)
+{
+	if (pixels == NULL || width < 1 || height < 1)
+		return false;
+
+	image.format = format;
+	image.levels.clear();
+	image.data.clear();
+	image.external = nullptr;
+
+	std::vector<unsigned char> level(pixels, pixels + static_cast<size_t>(width) * height * channels);
+	std::vector<unsigned char> next;
+	for (;;) {
+		CompressedImage::Level info;
+		info.width = width;
+		info.height = height;
+		info.offset = image.data.size();
+		info.size = getLevelSize(format, width, height);
+		image.data.resize(info.offset + info.size);
+
+		if (format == CompressedImage::BC5) {
+			compressBC5(level.data(), width, height, channels, &image.data[info.offset]);
+		}
+		else {
+			int size = 0;
+			unsigned char* blocks = format == CompressedImage::BC1
+				? convert_image_to_DXT1(level.data(), width, height, channels, &size)
+				: convert_image_to_DXT5(level.data(), width, height, channels, &size);
+			if (blocks == NULL || static_cast<size_t>(size) != info.size) {
+				free(blocks);
+				return false;
+			}
+			memcpy(&image.data[info.offset], blocks, info.size);
+			free(blocks);
+		}
+		image.levels.push_back(info);
+
+		if (width == 1 && height == 1)
+			break;
+		downsample(level.data(), width, height, channels, next);
+		level.swap(next);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return true;
+}
+
+// read a cache file, fails if it is missing, outdated or was written for a different source file
+bool TextureCompressor::load(const std::string& path, uint64_t sourceSize, uint64_t sourceTime, CompressedImage& image)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+		return false;
+
+	DDS_header header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& header.dwReserved1[1] == static_cast<unsigned int>(sourceSize)
+		&& header.dwReserved1[2] == static_cast<unsigned int>(sourceSize >> 32)
+		&& header.dwReserved1[3] == static_cast<unsigned int>(sourceTime)
+		&& header.dwReserved1[4] == static_cast<unsigned int>(sourceTime >> 32)
+		&& readHeader(&header, image);
+
+	if (valid) {
+		image.external = nullptr;
+		image.data.resize(image.getSize());
+		valid = fread(image.data.data(), 1, image.data.size(), file) == image.data.size();
+	}
+	fclose(file);
+	return valid;
+}
+
+// use a cache file that is already in memory without copying it, the memory has to outlive the image
+bool TextureCompressor::read(const char* data, size_t size, CompressedImage& image)
+{
+	DDS_header header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (!readHeader(&header, image) || size < sizeof(header) + image.getSize())
+		return false;
+
+	image.data.clear();
+	image.external = reinterpret_cast<const unsigned char*>(data + sizeof(header));
+	return true;
+}
+
+// check the header and compute the size of all levels
+bool TextureCompressor::readHeader(const void* data, CompressedImage& image)
+{
+	const DDS_header& header = *static_cast<const DDS_header*>(data);
+	if (header.dwMagic != DDS_MAGIC || header.dwReserved1[0] != CACHE_VERSION
+		|| header.dwWidth == 0 || header.dwHeight == 0 || header.dwMipMapCount == 0)
+		return false;
+
+	switch (header.sPixelFormat.dwFourCC) {
+	case FOURCC_DXT1: image.format = CompressedImage::BC1; break;
+	case FOURCC_DXT5: image.format = CompressedImage::BC3; break;
+	case FOURCC_ATI2: image.format = CompressedImage::BC5; break;
+	default: return false;
+	}
+
+	int width = static_cast<int>(header.dwWidth);
+	int height = static_cast<int>(header.dwHeight);
+	image.levels.clear();
+	size_t offset = 0;
+	for (unsigned int i = 0; i < header.dwMipMapCount; i++) {
+		CompressedImage::Level level = { width, height, offset, getLevelSize(image.format, width, height) };
+		image.levels.push_back(level);
+		offset += level.size;
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return true;
+}
+
+bool TextureCompressor::save(const std::string& path, uint64_t sourceSize, uint64_t sourceTime, const CompressedImage& image)
+{
+	if (image.levels.empty())
+		return false;
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		printf("Unable to write texture cache %s\n", path.c_str());
+		return false;
+	}
+
+	DDS_header header;
+	memset(&header, 0, sizeof(header));
+	header.dwMagic = DDS_MAGIC;
+	header.dwSize = 124;
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.dwWidth = image.levels[0].width;
+	header.dwHeight = image.levels[0].height;
+	header.dwPitchOrLinearSize = static_cast<unsigned int>(image.levels[0].size);
+	header.dwMipMapCount = static_cast<unsigned int>(image.levels.size());
+	header.dwReserved1[0] = CACHE_VERSION;
+	header.dwReserved1[1] = static_cast<unsigned int>(sourceSize);
+	header.dwReserved1[2] = static_cast<unsigned int>(sourceSize >> 32);
+	header.dwReserved1[3] = static_cast<unsigned int>(sourceTime);
+	header.dwReserved1[4] = static_cast<unsigned int>(sourceTime >> 32);
+	header.sPixelFormat.dwSize = 32;
+	header.sPixelFormat.dwFlags = DDPF_FOURCC;
+	header.sPixelFormat.dwFourCC = image.format == CompressedImage::BC1 ? FOURCC_DXT1 : image.format == CompressedImage::BC3 ? FOURCC_DXT5 : FOURCC_ATI2;
+	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(image.getData(), 1, image.getSize(), file) == image.getSize();
+	fclose(file);
+	return written;
+}
+
+// 2x2 box filter, odd sizes repeat their last row or column
+void TextureCompressor::downsample(const unsigned char* pixels, int width, int height, int channels, std::vector<unsigned char>& result)
+{
+	int nextWidth = std::max(width / 2, 1);
+	int nextHeight = std::max(height / 2, 1);
+	result.resize(static_cast<size_t>(nextWidth) * nextHeight * channels);
+
+	for (int y = 0; y < nextHeight; y++) {
+		int y0 = std::min(2 * y, height - 1);
+		int y1 = std::min(2 * y + 1, height - 1);
+		for (int x = 0; x < nextWidth; x++) {
+			int x0 = std::min(2 * x, width - 1);
+			int x1 = std::min(2 * x + 1, width - 1);
+			for (int c = 0; c < channels; c++) {
+				int sum = pixels[(y0 * width + x0) * channels + c] + pixels[(y0 * width + x1) * channels + c]
+					+ pixels[(y1 * width + x0) * channels + c] + pixels[(y1 * width + x1) * channels + c];
+				result[(y * nextWidth + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// every 4x4 block is a BC4 block of the red channel followed by one of the green channel
+void TextureCompressor::compressBC5(const unsigned char* pixels, int width, int height, int channels, unsigned char* blocks)
+{
+	unsigned char red[16];
+	unsigned char green[16];
+	for (int by = 0; by < height; by += 4) {
+		for (int bx = 0; bx < width; bx += 4) {
+			for (int i = 0; i < 16; i++) {
+				int x = std::min(bx + i % 4, width - 1);		// partial blocks repeat the border
+				int y = std::min(by + i / 4, height - 1);
+				const unsigned char* pixel = pixels + (static_cast<size_t>(y) * width + x) * channels;
+				red[i] = pixel[0];
+				green[i] = channels > 1 ? pixel[1] : pixel[0];
+			}
+			compressBC4Block(red, blocks);
+			compressBC4Block(green, blocks + 8);
+			blocks += 16;
+		}
+	}
+}
+
+// endpoints are the block minimum and maximum, the six values in between are interpolated
+void TextureCompressor::compressBC4Block(const unsigned char values[16], unsigned char block[8])
+{
+	int minValue = 255;
+	int maxValue = 0;
+	for (int i = 0; i < 16; i++) {
+		minValue = std::min(minValue, static_cast<int>(values[i]));
+		maxValue = std::max(maxValue, static_cast<int>(values[i]));
+	}
+
+	block[0] = static_cast<unsigned char>(maxValue);
+	block[1] = static_cast<unsigned char>(minValue);
+	uint64_t indices = 0;
+	int range = maxValue - minValue;
+	if (range > 0) {
+		for (int i = 0; i < 16; i++) {
+			// position on the line from max (0) to min (7), remapped to the index order of the format
+			int step = ((maxValue - values[i]) * 7 + range / 2) / range;
+			int index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+			indices |= static_cast<uint64_t>(index) << (3 * i);
+		}
+	}
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+}
+
+size_t TextureCompressor::getLevelSize(CompressedImage::Format format, int width, int height)
+{
+	size_t blockSize = format == CompressedImage::BC1 ? 8 : 16;
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
@@ -0,0 +1,50 @@
+#ifndef TEXTURE_COMPRESSOR_H
+#define TEXTURE_COMPRESSOR_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// Block compressed image with its complete mip chain, largest level first
+struct CompressedImage {
+	enum Format {
+		BC1,			// rgb, 4 bits per pixel
+		BC3,			// rgba, 8 bits per pixel
+		BC5				// two independent channels (red, green), 8 bits per pixel, used for normal and dudv maps
+	};
+
+	struct Level {
+		int width;
+		int height;
+		size_t offset;
+		size_t size;
+	};
+
+	Format format = BC1;
+	std::vector<Level> levels;
+	std::vector<unsigned char> data;
+	const unsigned char* external = nullptr;		// points into a mapped asset pack instead of data
+
+	const unsigned char* getData() const { return external != nullptr ? external : data.data(); }
+	size_t getSize() const { return levels.empty() ? 0 : levels.back().offset + levels.back().size; }
+};
+
+// Converts decoded images to BC1/BC3/BC5 and stores them as DDS files, used as cache next to the source images.
+// BC1 and BC3 blocks are encoded with SOIL's image_DXT, BC5 blocks are two BC4 blocks encoded here.
+class TextureCompressor {
+public:
+	static bool compress(const unsigned char* pixels, int width, int height, int channels, CompressedImage::Format format, CompressedImage& image);
+
+	static bool load(const std::string& path, uint64_t sourceSize, uint64_t sourceTime, CompressedImage& image);
+	static bool read(const char* data, size_t size, CompressedImage& image);
+	static bool save(const std::string& path, uint64_t sourceSize, uint64_t sourceTime, const CompressedImage& image);
+
+private:
+	static bool readHeader(const void* header, CompressedImage& image);
+	static void downsample(const unsigned char* pixels, int width, int height, int channels, std::vector<unsigned char>& result);
+	static void compressBC5(const unsigned char* pixels, int width, int height, int channels, unsigned char* blocks);
+	static void compressBC4Block(const unsigned char values[16], unsigned char block[8]);
+	static size_t getLevelSize(CompressedImage::Format format, int width, int height);
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "TextureManager.h"
+#include "AssetPack.h"
+#include "GLState.h"
+
+#include "External Libraries\SOIL\include\SOIL.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+static const CompressedImage::Format BLOCK_FORMATS[] = { CompressedImage::BC1, CompressedImage::BC3, CompressedImage::BC5 };
+static const GLenum GL_FORMATS[] = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RG_RGTC2 };
+
+static uint64_t getFileSize(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+	return static_cast<uint64_t>(file.tellg());
+}
+
+static uint64_t getModificationTime(const std::string& path)
+{
+	struct stat status;
+	return stat(path.c_str(), &status) == 0 ? static_cast<uint64_t>(status.st_mtime) : 0;
+}
+
+TextureManager::TextureManager(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = 1;
+	for (unsigned int i = 0; i < threadCount; i++)
+		mWorkers.push_back(std::thread(&TextureManager::work, this));
+}
+
+TextureManager::~TextureManager()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mJobAdded.notify_all();
+	for (std::thread& worker : mWorkers)
+		worker.join();
+
+	for (const Texture& texture : mTextures)
+		glDeleteTextures(1, &texture.id);
+	if (mPixelBuffer != 0)
+		glDeleteBuffers(1, &mPixelBuffer);
+}
+
+// GL thread: the returned texture is usable for binding right away, it has no content until it was uploaded
+GLuint TextureManager::load(const std::string& path, Format format)
+{
+	return request(GL_TEXTURE_2D, std::vector<std::string>(1, path), format);
+}
+
+// GL thread: array texture with one layer per file, all files need the same size
+GLuint TextureManager::loadArray(const std::vector<std::string>& paths, Format format)
+{
+	return request(GL_TEXTURE_2D_ARRAY, paths, format);
+}
+
+GLuint TextureManager::request(GLenum target, const std::vector<std::string>& paths, Format format)
+{
+	for (const Texture& texture : mTextures)
+		if (texture.target == target && texture.paths == paths && texture.format == format)
+			return texture.id;
+
+	Texture texture;
+	texture.target = target;
+	texture.paths = paths;
+	texture.format = format;
+	texture.width = 0;
+	texture.height = 0;
+	texture.levelCount = 0;
+	glGenTextures(1, &texture.id);
+	GLState::bindTexture(target, texture.id);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);		// workers read mTextures
+		mTextures.push_back(texture);
+		for (size_t layer = 0; layer < paths.size(); layer++) {
+			LoadedImage job;
+			job.texture = mTextures.size() - 1;
+			job.layer = layer;
+			job.valid = false;
+			mJobs.push_back(std::move(job));
+		}
+	}
+	mImageCount += paths.size();
+	mJobAdded.notify_all();
+	return texture.id;
+}
+
+// worker thread: load the next requested image
+void TextureManager::work()
+{
+	for (;;) {
+		std::string path;
+		Format format;
+		LoadedImage loaded;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobAdded.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+			if (mStopping)
+				return;
+			loaded = std::move(mJobs.front());
+			mJobs.pop_front();
+			path = mTextures[loaded.texture].paths[loaded.layer];
+			format = mTextures[loaded.texture].format;
+		}
+
+		loaded.valid = loadImage(path, format, loaded.image);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mReady.push_back(std::move(loaded));
+	}
+}
+
+std::string TextureManager::getCachePath(const std::string& path)
+{
+	return path + ".dds";
+}
+
+// read the DDS cache of an image, or decode and compress the image and write the cache for the next start
+bool TextureManager::loadImage(const std::string& path, Format format, CompressedImage& image)
+{
+	std::string cachePath = getCachePath(path);
+
+	// images in the asset pack are uploaded straight from the mapping
+	const char* packed;
+	size_t packedSize;
+	if (AssetPack::find(cachePath, packed, packedSize) && TextureCompressor::read(packed, packedSize, image) && image.format == BLOCK_FORMATS[format])
+		return true;
+
+	uint64_t sourceSize = getFileSize(path);
+	uint64_t sourceTime = getModificationTime(path);
+	if (TextureCompressor::load(cachePath, sourceSize, sourceTime, image) && image.format == BLOCK_FORMATS[format])
+		return true;
+
+	int width, height;
+	unsigned char* pixels = SOIL_load_image(path.c_str(), &width, &height, 0, format == RGBA ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+	if (pixels == NULL) {
+		printf("[TextureManager] Unable to load texture %s\n", path.c_str());
+		return false;
+	}
+
+	bool compressed = TextureCompressor::compress(pixels, width, height, format == RGBA ? 4 : 3, BLOCK_FORMATS[format], image);
+	SOIL_free_image_data(pixels);
+	if (!compressed) {
+		printf("[TextureManager] Unable to compress texture %s\n", path.c_str());
+		return false;
+	}
+	TextureCompressor::save(cachePath, sourceSize, sourceTime, image);
+	return true;
+}
+
+// GL thread: upload all images loaded so far, their CPU copies are freed when this returns
+int TextureManager::uploadReady()
+{
+	std::deque<LoadedImage> ready;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		ready.swap(mReady);
+	}
+
+	for (const LoadedImage& loaded : ready) {
+		if (loaded.valid)
+			upload(loaded);
+		mUploadedCount++;
+	}
+	return static_cast<int>(ready.size());
+}
+
+// copy the whole mip chain into a pixel buffer object and let the driver transfer it to the texture,
+// the buffer is orphaned before every upload so the copy never waits for the previous transfer
+void TextureManager::upload(const LoadedImage& loaded)
+{
+	Texture& target = mTextures[loaded.texture];
+	const CompressedImage& image = loaded.image;
+	GLenum format = GL_FORMATS[target.format];
+
+	GLState::bindTexture(target.target, target.id);
+	if (target.width == 0) {
+		// the first image decides the size, array storage is allocated before any pixel buffer is bound
+		target.width = image.levels[0].width;
+		target.height = image.levels[0].height;
+		target.levelCount = image.levels.size();
+		glTexParameteri(target.target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(target.levelCount) - 1);
+		if (target.target == GL_TEXTURE_2D_ARRAY) {
+			GLsizei layers = static_cast<GLsizei>(target.paths.size());
+			for (size_t i = 0; i < image.levels.size(); i++) {
+				const CompressedImage::Level& level = image.levels[i];
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), format, level.width, level.height, layers, 0,
+					static_cast<GLsizei>(level.size * layers), NULL);
+			}
+		}
+	}
+	else if (image.levels[0].width != target.width || image.levels[0].height != target.height || image.levels.size() != target.levelCount) {
+		printf("[TextureManager] %s does not match the size of the other layers\n", target.paths[loaded.layer].c_str());
+		return;
+	}
+
+	bool buffered = false;
+	if (mPixelBuffer == 0)
+		glGenBuffers(1, &mPixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, image.getSize(), NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image.getSize(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped != NULL) {
+		memcpy(mapped, image.getData(), image.getSize());
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		buffered = true;
+	}
+	else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	for (size_t i = 0; i < image.levels.size(); i++) {
+		const CompressedImage::Level& level = image.levels[i];
+		const void* levelData = buffered ? reinterpret_cast<const void*>(level.offset) : image.getData() + level.offset;
+		if (target.target == GL_TEXTURE_2D_ARRAY)
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), 0, 0, static_cast<GLint>(loaded.layer), level.width, level.height, 1,
+				format, static_cast<GLsizei>(level.size), levelData);
+		else
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0, static_cast<GLsizei>(level.size), levelData);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
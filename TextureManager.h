@@ -0,0 +1,78 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include "TextureCompressor.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Owns all image textures. load() and loadArray() return the texture name right away, the images are loaded
+// on worker threads and uploaded through a pixel buffer object in uploadReady() on the GL thread.
+// Textures are block compressed with a precomputed mip chain, the compressed data is cached in a DDS file
+// next to each source image. A texture requested more than once with the same files and format is only
+// loaded and stored once, the CPU copy is freed as soon as it is on the GPU.
+class TextureManager {
+public:
+	enum Format {
+		RGB,			// BC1
+		RGBA,			// BC3
+		RG				// BC5, the shader reconstructs the third component of normal maps
+	};
+
+	explicit TextureManager(unsigned int threadCount);
+	~TextureManager();
+
+	GLuint load(const std::string& path, Format format);
+	GLuint loadArray(const std::vector<std::string>& paths, Format format);
+	int uploadReady();
+
+	static std::string getCachePath(const std::string& path);
+
+	bool isFinished() const { return mUploadedCount == mImageCount; }
+	size_t getUploadedCount() const { return mUploadedCount; }
+	size_t getTotalCount() const { return mImageCount; }
+
+private:
+	struct LoadedImage {
+		size_t texture;
+		size_t layer;
+		bool valid;
+		CompressedImage image;
+	};
+
+	GLuint request(GLenum target, const std::vector<std::string>& paths, Format format);
+	void work();
+	static bool loadImage(const std::string& path, Format format, CompressedImage& image);
+	void upload(const LoadedImage& loaded);
+
+	struct Texture {
+		GLenum target;							// GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY with one layer per file
+		std::vector<std::string> paths;
+		Format format;
+		GLuint id;
+		int width;
+		int height;
+		size_t levelCount;
+	};
+
+	std::vector<Texture> mTextures;
+
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mJobAdded;
+	std::deque<LoadedImage> mJobs;						// images waiting to be loaded
+	std::deque<LoadedImage> mReady;						// loaded on a worker, waiting for upload
+	bool mStopping = false;
+
+	GLuint mPixelBuffer = 0;
+	size_t mImageCount = 0;
+	size_t mUploadedCount = 0;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "TransformBatch.h"
+#include "GLState.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <xmmintrin.h>
+
+using namespace glm;
+
+TransformBatch::TransformBatch()
+{
+	glGenBuffers(1, &mBuffer);
+	glGenTextures(1, &mTexture);
+
+	// the texture stays attached to the buffer when its store is replaced
+	glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+	GLState::bindTexture(GL_TEXTURE_BUFFER, mTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer);
+
+	// the spec only guarantees 65536 texels, a larger pass is drawn in batches that each see one range of the buffer
+	GLint maxTexels = 0;
+	GLint alignment = 1;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	size_t step = static_cast<size_t>(alignment) > TRANSFORM_BYTES ? alignment / TRANSFORM_BYTES : 1;	// ranges start aligned
+	mCapacity = std::max(static_cast<size_t>(maxTexels / TEXELS_PER_TRANSFORM) / step * step, step);
+}
+
+TransformBatch::~TransformBatch()
+{
+	glDeleteTextures(1, &mTexture);
+	glDeleteBuffers(1, &mBuffer);
+}
+
+void TransformBatch::clear()
+{
+	mModels.clear();
+}
+
+int TransformBatch::add(const mat4& model)
+{
+	mModels.push_back(model);
+	return static_cast<int>(mModels.size() - 1);
+}
+
+void TransformBatch::update(const mat4& viewProjection)
+{
+	size_t count = mModels.size();
+	mData.resize(count * TEXELS_PER_TRANSFORM * 4);
+
+	__m128 projection[4];
+	for (int i = 0; i < 4; i++)
+		projection[i] = _mm_loadu_ps(&viewProjection[i][0]);
+
+	for (size_t i = 0; i < count; i++) {
+		float* out = &mData[i * TEXELS_PER_TRANSFORM * 4];
+		__m128 model[4];
+		for (int column = 0; column < 4; column++) {
+			model[column] = _mm_loadu_ps(&mModels[i][column][0]);
+			_mm_storeu_ps(out + 4 * column, model[column]);
+		}
+
+		// every column of the product is a combination of the view projection columns
+		for (int column = 0; column < 4; column++) {
+			__m128 m = model[column];
+			__m128 result = _mm_mul_ps(projection[0], _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm_add_ps(result, _mm_mul_ps(projection[1], _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(projection[2], _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2))));
+			result = _mm_add_ps(result, _mm_mul_ps(projection[3], _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(out + 16 + 4 * column, result);
+		}
+	}
+
+	// one upload per pass into a new store, the previous pass may still be reading the old one
+	glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, mData.size() * sizeof(float), mData.data(), GL_STREAM_DRAW);
+
+	if (count > mCapacity) {
+		if (!mWarned)
+			printf("[TransformBatch] %zu transforms exceed the %zu of one texture buffer, they are drawn in batches\n", count, mCapacity);
+		mWarned = true;
+		mSelectedBatch = NO_BATCH;
+	}
+	else if (mSelectedBatch != 0) {
+		// back to the whole buffer after a large pass
+		GLState::bindTexture(GL_TEXTURE_BUFFER, mTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer);
+		mSelectedBatch = 0;
+	}
+}
+
+// only passes with more than mCapacity transforms switch the range of the texture
+int TransformBatch::select(int index)
+{
+	size_t batch = static_cast<size_t>(index) / mCapacity;
+	if (batch != mSelectedBatch) {
+		size_t first = batch * mCapacity;
+		size_t count = std::min(mCapacity, mModels.size() - first);
+		GLState::bindTexture(GL_TEXTURE_BUFFER, mTexture);
+		glTexBufferRange(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer, first * TRANSFORM_BYTES, count * TRANSFORM_BYTES);
+		mSelectedBatch = batch;
+	}
+	return static_cast<int>(index - batch * mCapacity);
+}
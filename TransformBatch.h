@@ -0,0 +1,47 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+
+// Matrices of all objects drawn in a render pass. The model view projection matrices are computed for all of them
+// in one SSE pass and uploaded into one texture buffer, the objects shader reads them with the index returned by
+// add() instead of multiplying the matrices per vertex.
+// Per object TEXELS_PER_TRANSFORM vec4: model matrix, model view projection matrix.
+// One texture buffer holds at most getCapacity() transforms, beyond that select() switches between ranges of it.
+class TransformBatch {
+public:
+	static const int TEXELS_PER_TRANSFORM = 8;
+
+	TransformBatch();
+	~TransformBatch();
+
+	void clear();
+	int add(const glm::mat4& model);
+	// computes and uploads the matrices of everything added since clear()
+	void update(const glm::mat4& viewProjection);
+
+	// makes the range holding the transform visible to the shaders and returns the index to use within it,
+	// the draws of one range should follow each other
+	int select(int index);
+
+	GLuint getTexture() const { return mTexture; }
+	size_t size() const { return mModels.size(); }
+	size_t getCapacity() const { return mCapacity; }
+
+private:
+	static const size_t TRANSFORM_BYTES = TEXELS_PER_TRANSFORM * 4 * sizeof(float);
+	static const size_t NO_BATCH = ~static_cast<size_t>(0);
+
+	std::vector<glm::mat4> mModels;
+	std::vector<float> mData;
+	GLuint mBuffer = 0;
+	GLuint mTexture = 0;
+	size_t mCapacity = 1;
+	size_t mSelectedBatch = 0;		// range of the buffer the texture shows, 0 is the whole buffer in small passes
+	bool mWarned = false;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "VegetationScatter.h"
+#include "Terrain.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace glm;
+
+static const int SAMPLE_ATTEMPTS = 30;		// candidates around an active sample before it is retired
+static const float MEADOW_EDGE = 0.05f;		// width of the noise range over which the meadows thin out
+static const float TWO_PI = 6.28318531f;
+
+static float smoothStep(float edge0, float edge1, float x)
+{
+	float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+// random value in [0, 1] for a point of the noise lattice
+static float latticeValue(int x, int z, unsigned int seed)
+{
+	uint32_t h = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(z) * 668265263u + seed * 2246822519u;
+	h = (h ^ (h >> 13)) * 1274126177u;
+	h ^= h >> 16;
+	return (h & 0xffffff) / static_cast<float>(0xffffff);
+}
+
+static float valueNoise(float x, float z, unsigned int seed)
+{
+	float fx = floorf(x);
+	float fz = floorf(z);
+	int ix = static_cast<int>(fx);
+	int iz = static_cast<int>(fz);
+	float tx = smoothStep(0.0f, 1.0f, x - fx);
+	float tz = smoothStep(0.0f, 1.0f, z - fz);
+	float top = latticeValue(ix, iz, seed) + (latticeValue(ix + 1, iz, seed) - latticeValue(ix, iz, seed)) * tx;
+	float bottom = latticeValue(ix, iz + 1, seed) + (latticeValue(ix + 1, iz + 1, seed) - latticeValue(ix, iz + 1, seed)) * tx;
+	return top + (bottom - top) * tz;
+}
+
+VegetationScatter::VegetationScatter(const Terrain* terrain, float chunkSize, const Rules& rules, unsigned int seed) :
+	mTerrain(terrain),
+	mChunkSize(chunkSize),
+	mRules(rules),
+	mSeed(seed)
+{
+	vec3 boundsMin, boundsMax;
+	terrain->getBounds(boundsMin, boundsMax);
+	mHalfSize = 0.5f * (boundsMax.x - boundsMin.x);
+	mChunksPerSide = static_cast<int>(ceilf(2.0f * mHalfSize / chunkSize));
+}
+
+// bilinear between the height values, x and z are clamped to the terrain
+float VegetationScatter::sampleHeight(float x, float z) const
+{
+	x = std::min(std::max(x, -mHalfSize), mHalfSize - 1.0f);
+	z = std::min(std::max(z, -mHalfSize), mHalfSize - 1.0f);
+	float fx = floorf(x);
+	float fz = floorf(z);
+	float tx = x - fx;
+	float tz = z - fz;
+	float top = mTerrain->getHeightValue(fx, fz) + (mTerrain->getHeightValue(fx + 1.0f, fz) - mTerrain->getHeightValue(fx, fz)) * tx;
+	float bottom = mTerrain->getHeightValue(fx, fz + 1.0f) + (mTerrain->getHeightValue(fx + 1.0f, fz + 1.0f) - mTerrain->getHeightValue(fx, fz + 1.0f)) * tx;
+	return top + (bottom - top) * tz;
+}
+
+// two octaves of value noise in [0, 1], the meadows are where it is above 1 - coverage
+float VegetationScatter::meadowNoise(float x, float z) const
+{
+	float frequency = 1.0f / mRules.meadowSize;
+	float noise = valueNoise(x * frequency, z * frequency, mSeed);
+	noise += 0.5f * valueNoise(2.0f * x * frequency, 2.0f * z * frequency, mSeed + 1);
+	return noise / 1.5f;
+}
+
+void VegetationScatter::generate(unsigned int threadCount)
+{
+	size_t chunkCount = static_cast<size_t>(mChunksPerSide * mChunksPerSide);
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	size_t workerCount = std::min(std::max(static_cast<size_t>(threadCount), static_cast<size_t>(1)), chunkCount);
+
+	std::vector<std::vector<float>> chunkInstances(chunkCount);
+	auto work = [this, &chunkInstances](size_t first, size_t last) {
+		for (size_t chunk = first; chunk < last; chunk++)
+			generateChunk(chunk, chunkInstances[chunk]);
+	};
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < workerCount; i++)
+		workers.push_back(std::thread(work, chunkCount * i / workerCount, chunkCount * (i + 1) / workerCount));
+	work(0, chunkCount / workerCount);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// the instances of all chunks in one array, empty chunks are dropped
+	mChunks.clear();
+	mInstances.clear();
+	for (const std::vector<float>& instances : chunkInstances) {
+		if (instances.empty())
+			continue;
+		Chunk chunk;
+		chunk.first = static_cast<uint32_t>(mInstances.size() / INSTANCE_FLOATS);
+		chunk.count = static_cast<uint32_t>(instances.size() / INSTANCE_FLOATS);
+		chunk.boundsMin = vec3(FLT_MAX);
+		chunk.boundsMax = vec3(-FLT_MAX);
+		for (size_t i = 0; i < instances.size(); i += INSTANCE_FLOATS) {
+			vec3 position = vec3(instances[i], instances[i + 1], instances[i + 2]);
+			chunk.boundsMin = min(chunk.boundsMin, position);
+			chunk.boundsMax = max(chunk.boundsMax, position);
+		}
+		mChunks.push_back(chunk);
+		mInstances.insert(mInstances.end(), instances.begin(), instances.end());
+	}
+}
+
+void VegetationScatter::generateChunk(size_t chunk, std::vector<float>& instances) const
+{
+	float radius = mRules.minDistance;
+	float chunkX = -mHalfSize + (chunk % mChunksPerSide) * mChunkSize;
+	float chunkZ = -mHalfSize + (chunk / mChunksPerSide) * mChunkSize;
+	float minX = chunkX + 0.5f * radius;
+	float minZ = chunkZ + 0.5f * radius;
+	float maxX = std::min(chunkX + mChunkSize, mHalfSize) - 0.5f * radius;
+	float maxZ = std::min(chunkZ + mChunkSize, mHalfSize) - 0.5f * radius;
+	if (minX >= maxX || minZ >= maxZ)
+		return;
+
+	std::mt19937 random(mSeed * 2654435761u + static_cast<unsigned int>(chunk));
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// background grid with at most one sample per cell
+	float cellSize = radius / sqrtf(2.0f);
+	int gridWidth = static_cast<int>(ceilf((maxX - minX) / cellSize));
+	int gridHeight = static_cast<int>(ceilf((maxZ - minZ) / cellSize));
+	std::vector<int> grid(gridWidth * gridHeight, -1);
+	std::vector<vec2> samples;
+	std::vector<int> active;
+	auto cellOf = [&](const vec2& p, int& x, int& z) {
+		x = std::min(static_cast<int>((p.x - minX) / cellSize), gridWidth - 1);
+		z = std::min(static_cast<int>((p.y - minZ) / cellSize), gridHeight - 1);
+	};
+	auto insert = [&](const vec2& p) {
+		int x, z;
+		cellOf(p, x, z);
+		grid[z * gridWidth + x] = static_cast<int>(samples.size());
+		active.push_back(static_cast<int>(samples.size()));
+		samples.push_back(p);
+	};
+
+	insert(vec2(minX + unit(random) * (maxX - minX), minZ + unit(random) * (maxZ - minZ)));
+	while (!active.empty()) {
+		size_t current = std::min(static_cast<size_t>(unit(random) * active.size()), active.size() - 1);
+		vec2 center = samples[active[current]];
+		bool found = false;
+		for (int attempt = 0; attempt < SAMPLE_ATTEMPTS && !found; attempt++) {
+			// candidates in the ring between radius and twice the radius
+			float angle = unit(random) * TWO_PI;
+			float distance = radius * (1.0f + unit(random));
+			vec2 candidate = center + distance * vec2(cosf(angle), sinf(angle));
+			if (candidate.x < minX || candidate.x > maxX || candidate.y < minZ || candidate.y > maxZ)
+				continue;
+
+			int cellX, cellZ;
+			cellOf(candidate, cellX, cellZ);
+			bool free = true;
+			for (int z = std::max(cellZ - 2, 0); z <= std::min(cellZ + 2, gridHeight - 1) && free; z++)
+				for (int x = std::max(cellX - 2, 0); x <= std::min(cellX + 2, gridWidth - 1) && free; x++) {
+					int other = grid[z * gridWidth + x];
+					if (other >= 0 && dot(samples[other] - candidate, samples[other] - candidate) < radius * radius)
+						free = false;
+				}
+			if (free) {
+				insert(candidate);
+				found = true;
+			}
+		}
+		if (!found) {
+			active[current] = active.back();
+			active.pop_back();
+		}
+	}
+
+	// the rules only remove samples, so the remaining plants keep their distance
+	struct Plant {
+		vec3 position;
+		float scale;
+		float angle;
+	};
+	std::vector<Plant> plants;
+	float threshold = 1.0f - mRules.coverage;
+	for (const vec2& sample : samples) {
+		float height = sampleHeight(sample.x, sample.y);
+		if (height < mRules.minHeight || height > mRules.maxHeight)
+			continue;
+		float slopeX = 0.5f * (sampleHeight(sample.x + 1.0f, sample.y) - sampleHeight(sample.x - 1.0f, sample.y));
+		float slopeZ = 0.5f * (sampleHeight(sample.x, sample.y + 1.0f) - sampleHeight(sample.x, sample.y - 1.0f));
+		if (slopeX * slopeX + slopeZ * slopeZ > mRules.maxSlope * mRules.maxSlope)
+			continue;
+		// the edges of the meadows are thinned out gradually
+		float density = smoothStep(threshold - MEADOW_EDGE, threshold + MEADOW_EDGE, meadowNoise(sample.x, sample.y));
+		if (unit(random) >= density)
+			continue;
+
+		Plant plant;
+		plant.position = vec3(sample.x, height, sample.y);
+		plant.scale = mRules.minScale + unit(random) * (mRules.maxScale - mRules.minScale);
+		plant.angle = unit(random) * TWO_PI;
+		plants.push_back(plant);
+	}
+
+	// shuffled, any prefix is spread over the whole chunk
+	std::shuffle(plants.begin(), plants.end(), random);
+	instances.reserve(plants.size() * INSTANCE_FLOATS);
+	for (const Plant& plant : plants) {
+		float instance[INSTANCE_FLOATS] = { plant.position.x, plant.position.y, plant.position.z, plant.scale, cosf(plant.angle), 0.0f, sinf(plant.angle), 0.0f };
+		instances.insert(instances.end(), instance, instance + INSTANCE_FLOATS);
+	}
+}
+
+uint32_t VegetationScatter::getDrawCount(const Chunk& chunk, float distance) const
+{
+	if (distance <= mRules.fadeStart)
+		return chunk.count;
+	if (distance >= mRules.fadeEnd)
+		return 0;
+	float fraction = 1.0f - (distance - mRules.fadeStart) / (mRules.fadeEnd - mRules.fadeStart);
+	return static_cast<uint32_t>(chunk.count * fraction);
+}
@@ -0,0 +1,73 @@
+#ifndef VEGETATION_SCATTER_H
+#define VEGETATION_SCATTER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+class Terrain;
+
+// Plants distributed over the seafloor by Poisson disk sampling (Bridson), so that no two are closer than
+// minDistance. The terrain is split into square chunks that are sampled on worker threads, each with its own
+// random sequence, so the result does not depend on the thread count. Samples keep half the distance to the
+// chunk border, which keeps the distance across chunks as well. A sample grows if the height and slope rules
+// allow it and it lies in a meadow, given by a smooth noise over the seafloor.
+// The instances of a chunk are consecutive and shuffled, a prefix of them is an even thinning for the distance.
+class VegetationScatter {
+public:
+	struct Rules {
+		float minDistance = 1.5f;		// between two plants
+		float minHeight = -1e30f;		// terrain heights the plants grow on
+		float maxHeight = 1e30f;
+		float maxSlope = 0.8f;			// rise over run
+		float meadowSize = 30.0f;		// scale of the meadow noise
+		float coverage = 0.4f;			// fraction of the seafloor covered by meadows
+		float minScale = 1.0f;
+		float maxScale = 1.0f;
+		float fadeStart = 60.0f;		// distances over which the chunks are thinned out to nothing
+		float fadeEnd = 200.0f;
+	};
+
+	// world space bounds of the plant positions and the range of instances
+	struct Chunk {
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	// the terrain has to be centered in (0,0)
+	VegetationScatter(const Terrain* terrain, float chunkSize, const Rules& rules, unsigned int seed);
+
+	// threadCount 0 uses the hardware concurrency
+	void generate(unsigned int threadCount = 0);
+
+	// instances of the chunk to draw at this distance
+	uint32_t getDrawCount(const Chunk& chunk, float distance) const;
+
+	const std::vector<Chunk>& getChunks() const { return mChunks; }
+	size_t size() const { return mInstances.size() / INSTANCE_FLOATS; }
+	const Rules& getRules() const { return mRules; }
+
+	// per plant: position and scale, facing direction and 0, the layout of the instanced draw
+	const std::vector<float>& getInstances() const { return mInstances; }
+	static const size_t INSTANCE_FLOATS = 8;
+
+private:
+	void generateChunk(size_t chunk, std::vector<float>& instances) const;
+	float sampleHeight(float x, float z) const;
+	float meadowNoise(float x, float z) const;
+
+	const Terrain* mTerrain;
+	float mChunkSize;
+	Rules mRules;
+	unsigned int mSeed;
+	float mHalfSize;			// the terrain covers -mHalfSize to mHalfSize
+	int mChunksPerSide;
+
+	std::vector<Chunk> mChunks;
+	std::vector<float> mInstances;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "VertexAnimation.h"
+#include "Object.h"
+#include "QuantizedMesh.h"
+#include "AssetPack.h"
+#include "GLState.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+using namespace glm;
+
+static const char ANIMATION_MAGIC[4] = { 'V', 'A', 'N', 'M' };
+static const uint32_t ANIMATION_VERSION = 2;
+static const unsigned int MAX_WIDTH = 1024;		// vertices per texture row
+static const float TWO_PI = 6.28318531f;
+
+// header of the baked file, followed by the half float texels of all frames
+struct VertexAnimationHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceSize;
+	uint32_t vertexCount;
+	uint32_t frameCount;
+	uint32_t width;
+	uint32_t rowsPerFrame;
+	float duration;
+};
+
+static uint64_t getFileSize(const char* path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+	return static_cast<uint64_t>(file.tellg());
+}
+
+static float smoothStep(float edge0, float edge1, float x)
+{
+	float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+std::string VertexAnimation::getCachePath(const char* objectFile)
+{
+	return std::string(objectFile) + ".vanim";
+}
+
+vec3 VertexAnimation::swimCycle(const vec3& position, float cycle, const vec3& boundsMin, const vec3& boundsExtent)
+{
+	float angle = TWO_PI * cycle;
+	float bodyLength = boundsExtent.z;
+	float back = 1.0f - (position.z - boundsMin.z) / bodyLength;		// 0 at the head, 1 at the tail
+	vec3 center = boundsMin + 0.5f * boundsExtent;
+
+	// lateral wave growing towards the tail and a flap of the tail fin behind it
+	float bend = 0.1f * back * back * sinf(angle - 5.0f * back);
+	float flap = 0.08f * smoothStep(0.75f, 1.0f, back) * sinf(angle - 5.0f);
+	// the body heaves twice per beat and rolls against the bend
+	float heave = 0.01f * sinf(2.0f * angle);
+	float roll = 0.08f * cosf(angle);
+
+	float x = position.x - center.x;
+	float y = position.y - center.y;
+	vec3 result;
+	result.x = center.x + x * cosf(roll) - y * sinf(roll) + (bend + flap) * bodyLength;
+	result.y = center.y + x * sinf(roll) + y * cosf(roll) + heave * bodyLength;
+	result.z = position.z;
+	return result;
+}
+
+// evaluates the deformation for every vertex of the mesh and frame, does not touch OpenGL
+bool VertexAnimation::bake(const char* objectFile, Deformation deformation, unsigned int frameCount, float duration)
+{
+	QuantizedMesh mesh = Object::loadMesh(objectFile);
+	unsigned int vertexCount = mesh.getVertexCount();
+	if (vertexCount == 0 || frameCount == 0) {
+		printf("[VertexAnimation] Nothing to bake for %s\n", objectFile);
+		return false;
+	}
+
+	unsigned int width = std::min(vertexCount, MAX_WIDTH);
+	unsigned int rowsPerFrame = (vertexCount + width - 1) / width;
+	std::vector<uint16_t> texels(static_cast<size_t>(frameCount) * rowsPerFrame * width * 4, 0);
+
+	// only the positions, the objects shader lights with the normal map and not with the vertex normals
+	vec3 boundsMin = mesh.getBoundsMin();
+	vec3 boundsExtent = mesh.getBoundsExtent();
+	for (unsigned int frame = 0; frame < frameCount; frame++) {
+		float cycle = frame / static_cast<float>(frameCount);
+		for (unsigned int vertex = 0; vertex < vertexCount; vertex++) {
+			vec3 deformedPosition = deformation(mesh.getPosition(vertex), cycle, boundsMin, boundsExtent);
+			size_t row = static_cast<size_t>(frame) * rowsPerFrame + vertex / width;
+			uint16_t* positionTexel = &texels[(row * width + vertex % width) * 4];
+			for (int i = 0; i < 3; i++)
+				positionTexel[i] = QuantizedMesh::floatToHalf(deformedPosition[i]);
+		}
+	}
+
+	std::string path = getCachePath(objectFile);
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		printf("[VertexAnimation] Unable to write %s\n", path.c_str());
+		return false;
+	}
+
+	VertexAnimationHeader header;
+	memcpy(header.magic, ANIMATION_MAGIC, sizeof(ANIMATION_MAGIC));
+	header.version = ANIMATION_VERSION;
+	header.sourceSize = getFileSize(objectFile);
+	header.vertexCount = vertexCount;
+	header.frameCount = frameCount;
+	header.width = width;
+	header.rowsPerFrame = rowsPerFrame;
+	header.duration = duration;
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(texels.data(), sizeof(uint16_t), texels.size(), file) == texels.size();
+	fclose(file);
+	if (written)
+		printf("[VertexAnimation] Baked %u frames of %u vertices to %s\n", frameCount, vertexCount, path.c_str());
+	else
+		printf("[VertexAnimation] Unable to write %s\n", path.c_str());
+	return written;
+}
+
+// reads the baked frames from the asset pack or the file next to the OBJ file, fails if it is missing or outdated
+bool VertexAnimation::load(const char* objectFile, unsigned int vertexCount)
+{
+	std::string path = getCachePath(objectFile);
+	std::vector<char> content;
+	const char* data;
+	size_t size;
+	bool packed = AssetPack::find(path, data, size);
+	if (!packed) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			printf("[VertexAnimation] %s not found, bake it with --bake-vat\n", path.c_str());
+			return false;
+		}
+		content.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(content.data(), content.size());
+		data = content.data();
+		size = content.size();
+	}
+
+	VertexAnimationHeader header;
+	if (size < sizeof(header)) {
+		printf("[VertexAnimation] %s is invalid\n", path.c_str());
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	size_t texelCount = static_cast<size_t>(header.frameCount) * header.rowsPerFrame * header.width * 4;
+	if (memcmp(header.magic, ANIMATION_MAGIC, sizeof(ANIMATION_MAGIC)) != 0 || header.version != ANIMATION_VERSION
+		|| size < sizeof(header) + texelCount * sizeof(uint16_t)) {
+		printf("[VertexAnimation] %s is invalid\n", path.c_str());
+		return false;
+	}
+	// the pack is built from up to date files, the OBJ file does not need to exist
+	if (!packed && header.sourceSize != getFileSize(objectFile)) {
+		printf("[VertexAnimation] %s is outdated, bake it with --bake-vat\n", path.c_str());
+		return false;
+	}
+	// the texels are fetched with the vertex id, another vertex order would tear the mesh apart
+	if (header.vertexCount != vertexCount) {
+		printf("[VertexAnimation] %s was baked for %u vertices, the mesh has %u\n", path.c_str(), header.vertexCount, vertexCount);
+		return false;
+	}
+
+	mVertexCount = header.vertexCount;
+	mFrameCount = header.frameCount;
+	mWidth = header.width;
+	mRowsPerFrame = header.rowsPerFrame;
+	mDuration = header.duration;
+
+	if (mTexture == 0)
+		glGenTextures(1, &mTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mWidth, mFrameCount * mRowsPerFrame, 0, GL_RGBA, GL_HALF_FLOAT, data + sizeof(header));
+	return true;
+}
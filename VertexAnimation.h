@@ -0,0 +1,42 @@
+#ifndef VERTEX_ANIMATION_H
+#define VERTEX_ANIMATION_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <stdint.h>
+
+// Baked vertex animation: the object space position of every vertex for every frame of a cycle, stored in a
+// half float texture that the objects shader reads with the vertex id instead of the mesh positions.
+// bake() evaluates a deformation offline and writes the frames to a file next to the OBJ file, load() reads it
+// and creates the texture. Rows of one frame: the positions of width vertices per row.
+class VertexAnimation {
+public:
+	// deformed object space position, cycle runs from 0 to 1 over the animation
+	typedef glm::vec3 (*Deformation)(const glm::vec3& position, float cycle, const glm::vec3& boundsMin, const glm::vec3& boundsExtent);
+
+	static bool bake(const char* objectFile, Deformation deformation, unsigned int frameCount, float duration);
+	static std::string getCachePath(const char* objectFile);
+
+	// body wave with tail flap, heave and roll of a fish looking along +z
+	static glm::vec3 swimCycle(const glm::vec3& position, float cycle, const glm::vec3& boundsMin, const glm::vec3& boundsExtent);
+
+	// has to be called on the GL thread, fails if the file was baked for a mesh with a different vertex count
+	bool load(const char* objectFile, unsigned int vertexCount);
+
+	GLuint getTexture() const { return mTexture; }
+	unsigned int getFrameCount() const { return mFrameCount; }
+	unsigned int getWidth() const { return mWidth; }
+	unsigned int getRowsPerFrame() const { return mRowsPerFrame; }
+	float getDuration() const { return mDuration; }
+
+private:
+	GLuint mTexture = 0;
+	unsigned int mVertexCount = 0;
+	unsigned int mFrameCount = 0;
+	unsigned int mWidth = 0;
+	unsigned int mRowsPerFrame = 0;
+	float mDuration = 1.0f;				// seconds of one cycle
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "VertexArrayObject.h"
+#include "QuantizedMesh.h"
+#include "GLState.h"
 
 VertexArrayObject::VertexArrayObject()
 {
@@ -24,7 +26,7 @@ void VertexArrayObject::begin(unsigned int drawMode)
 	if (mVAO == 0)
 		glGenVertexArrays(1, &mVAO);
 
-	glBindVertexArray(mVAO);
+	GLState::bindVertexArray(mVAO);
 
 }
 
@@ -123,27 +125,110 @@ void VertexArrayObject::end()
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0], GL_STATIC_DRAW);
 	}
 
-	glBindVertexArray(0);
+	mVertexCount = mPositions.size() / 4;
+	GLState::bindVertexArray(0);
+}
+
+// end a Vertex Array Object with compressed attributes: positions as normalized ushort (dequantized in the shader),
+// octahedral normals as normalized short and texcoords as half floats. The float arrays are not used.
+// The index buffer is part of the VAO state and uses 16-bit indices when the vertex count allows it.
+void VertexArrayObject::endQuantized(const QuantizedMesh& mesh)
+{
+	glGenBuffers(1, &mPositionBufferHandle);
+	glBindBuffer(GL_ARRAY_BUFFER, mPositionBufferHandle);
+	glBufferData(GL_ARRAY_BUFFER, mesh.mPositions.size() * sizeof(uint16_t), mesh.mPositions.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, 0, NULL);
+	glEnableVertexAttribArray(0);
+
+	if (mesh.mNormals.size() > 0) {
+		glGenBuffers(1, &mNormalBufferHandle);
+		glBindBuffer(GL_ARRAY_BUFFER, mNormalBufferHandle);
+		glBufferData(GL_ARRAY_BUFFER, mesh.mNormals.size() * sizeof(int16_t), mesh.mNormals.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, 0, NULL);
+		glEnableVertexAttribArray(2);
+	}
+
+	if (mesh.mTexCoords.size() > 0) {
+		glGenBuffers(1, &mTexCoordBufferHandle);
+		glBindBuffer(GL_ARRAY_BUFFER, mTexCoordBufferHandle);
+		glBufferData(GL_ARRAY_BUFFER, mesh.mTexCoords.size() * sizeof(uint16_t), mesh.mTexCoords.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, 0, NULL);
+		glEnableVertexAttribArray(3);
+	}
+
+	if (mesh.mIndices.size() > 0) {
+		glGenBuffers(1, &mIndexBufferHandle);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferHandle);
+		if (mesh.getVertexCount() <= 0x10000) {
+			std::vector<uint16_t> shortIndices(mesh.mIndices.begin(), mesh.mIndices.end());
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+			mIndexType = GL_UNSIGNED_SHORT;
+		}
+		else {
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.mIndices.size() * sizeof(uint32_t), mesh.mIndices.data(), GL_STATIC_DRAW);
+			mIndexType = GL_UNSIGNED_INT;
+		}
+		mIndexCount = static_cast<GLsizei>(mesh.mLods.empty() ? mesh.mIndices.size() : mesh.mLods[0].indexCount);
+	}
+
+	mVertexCount = mesh.getVertexCount();
+	GLState::bindVertexArray(0);
 }
 
 // draw Function: check if VAO contains indices, then call glDrawArrays or glDrawElements
 void VertexArrayObject::draw()
 {
-	if (mIndices.size() == 0) {
+	if (mIndexCount > 0) {
+		drawRange(0, mIndexCount);
+	}
+	else if (mIndices.size() == 0) {
 
-		glBindVertexArray(mVAO);
-		glDrawArrays(mDrawMode, 0, mPositions.size() / 4);
-		glBindVertexArray(0);
+		GLState::bindVertexArray(mVAO);
+		glDrawArrays(mDrawMode, 0, mVertexCount);
 	}
 	else {
 
+		// the VAO stays bound after the draw, the element buffer has to be bound into it and not into the previous one
+		GLState::bindVertexArray(mVAO);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferHandle);
-		glBindVertexArray(mVAO);
 		glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, NULL);
-		glBindVertexArray(0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	}
 }
 
+// draw a range of the index buffer from endQuantized, e.g. one level of detail
+void VertexArrayObject::drawRange(GLsizei firstIndex, GLsizei indexCount)
+{
+	size_t indexSize = mIndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	GLState::bindVertexArray(mVAO);
+	glDrawElements(mDrawMode, indexCount, mIndexType, reinterpret_cast<const void*>(firstIndex * indexSize));
+}
+
+
 
+void VertexArrayObject::setInstanceData(const float* data, size_t instanceCount)
+{
+	GLState::bindVertexArray(mVAO);
+	if (mInstanceBufferHandle == 0) {
+		glGenBuffers(1, &mInstanceBufferHandle);
+		glBindBuffer(GL_ARRAY_BUFFER, mInstanceBufferHandle);
+		for (GLuint i = 0; i < 2; i++) {
+			glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<const void*>(4 * i * sizeof(float)));
+			glVertexAttribDivisor(4 + i, 1);
+			glEnableVertexAttribArray(4 + i);
+		}
+	}
+	else
+		glBindBuffer(GL_ARRAY_BUFFER, mInstanceBufferHandle);
+
+	// a new store every frame, the driver does not have to wait for the draws still reading the old one
+	glBufferData(GL_ARRAY_BUFFER, instanceCount * 8 * sizeof(float), data, GL_STREAM_DRAW);
+}
+
+// baseInstance is the first instance read from the instance buffer
+void VertexArrayObject::drawRangeInstanced(GLsizei firstIndex, GLsizei indexCount, GLsizei instanceCount, GLuint baseInstance)
+{
+	size_t indexSize = mIndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	GLState::bindVertexArray(mVAO);
+	glDrawElementsInstancedBaseInstance(mDrawMode, indexCount, mIndexType, reinterpret_cast<const void*>(firstIndex * indexSize), instanceCount, baseInstance);
+}
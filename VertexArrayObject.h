@@ -6,6 +6,8 @@
 
 #include <vector>
 
+class QuantizedMesh;
+
 class VertexArrayObject {
 
 public:
@@ -22,8 +24,17 @@ public:
 	void addIndex1ui(unsigned int i);
 
 	void end();
+	void endQuantized(const QuantizedMesh& mesh);
+
+	virtual void draw();
+	void drawRange(GLsizei firstIndex, GLsizei indexCount);
+
+	// per instance data as two vec4 per instance in the attributes 4 and 5, replaced by every call
+	void setInstanceData(const float* data, size_t instanceCount);
+	void drawRangeInstanced(GLsizei firstIndex, GLsizei indexCount, GLsizei instanceCount, GLuint baseInstance = 0);
 
-	void draw();
+	GLuint getVAO() const { return mVAO; }
+	GLsizei getVertexCount() const { return mVertexCount; }
 
 protected:
 
@@ -35,6 +46,10 @@ protected:
 	GLuint mNormalBufferHandle;
 	GLuint mTexCoordBufferHandle;
 	GLuint mIndexBufferHandle;
+	GLuint mInstanceBufferHandle = 0;
+	GLsizei mVertexCount = 0;
+	GLsizei mIndexCount = 0;       // indices of the full mesh uploaded by endQuantized
+	GLenum mIndexType = GL_UNSIGNED_INT;
 
 	std::vector<float> mPositions;        // the VBO data is stored in dynamic arrays
 	std::vector<float> mColors;
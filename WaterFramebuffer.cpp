@@ -1,4 +1,5 @@
 #include "WaterFramebuffer.h"
+#include "GLState.h"
 
 WaterFramebuffer::WaterFramebuffer(int width, int height)
 {
@@ -42,7 +43,7 @@ GLuint WaterFramebuffer::createFrameBuffer()
 {
 	GLuint framebuffer = 0;
 	glGenFramebuffers(1, &framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	GLState::bindFramebuffer(framebuffer);
 	return framebuffer;
 }
 
@@ -60,7 +61,7 @@ GLuint WaterFramebuffer::createTextureAttachment(int width, int height)
 {
 	GLuint renderedTexture;
 	glGenTextures(1, &renderedTexture);
-	glBindTexture(GL_TEXTURE_2D, renderedTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, renderedTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -72,7 +73,7 @@ GLuint WaterFramebuffer::createDepthTextureAttachment(int width, int height)
 {
 	GLuint depthTexture;
 	glGenTextures(1, &depthTexture);
-	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	GLState::bindTexture(GL_TEXTURE_2D, depthTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -82,9 +83,9 @@ GLuint WaterFramebuffer::createDepthTextureAttachment(int width, int height)
 
 void WaterFramebuffer::bindFramebuffer(GLuint frameBuffer, int width, int height)
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
-	glViewport(0, 0, width, height);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindFramebuffer(frameBuffer);
+	GLState::viewport(0, 0, width, height);
 }
 
 void WaterFramebuffer::bindReflectionFrameBuffer()
@@ -99,7 +100,7 @@ void WaterFramebuffer::bindRefractionFrameBuffer()
 
 void WaterFramebuffer::unbindCurrentFramebuffer()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 	glDrawBuffer(GL_BACK);
-	glViewport(0, 0, screenWidth, screenHeight);
+	GLState::viewport(0, 0, screenWidth, screenHeight);
 }
\ No newline at end of file